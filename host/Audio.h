@@ -0,0 +1,13 @@
+/* -*- mode: c++; tab-width: 8 -*- */
+/*
+** Host stand in for the Teensy Audio library header.
+*/
+#ifndef Audio_h_
+#define Audio_h_
+
+#include "AudioStream.h"
+#include "arm_math.h"
+#include "synth_waveform.h"
+#include "filter_variable.h"
+
+#endif
@@ -0,0 +1,231 @@
+/* -*- mode: c++; tab-width: 8 -*- */
+/*
+  Copyright (C) 2018 by Roger E Critchlow Jr, Charlestown, MA, USA.
+
+  This program is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation; either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program; if not, write to the Free Software
+  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307 USA
+*/
+/*
+** A host stand in for the Teensy Audio library's AudioStream,
+** enough to run the sketch's audio objects on Linux.
+**
+** Objects are updated in the order they were constructed, as on
+** the Teensy, when the caller calls AudioStream::update_all() rather
+** than from the audio interrupt.  Blocks come from a fixed pool
+** sized by AudioMemory() and are reference counted.  Each object
+** accumulates the host cycles spent in its update().
+*/
+#ifndef AudioStream_h
+#define AudioStream_h
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stddef.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <time.h>
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+
+#define AUDIO_BLOCK_SAMPLES  128
+#define AUDIO_SAMPLE_RATE_EXACT 44117.64706f
+#define AUDIO_SAMPLE_RATE AUDIO_SAMPLE_RATE_EXACT
+
+/* the bits of the Teensy core the audio objects use */
+#define __disable_irq()
+#define __enable_irq()
+/* the sketch's clock, advanced by the host program */
+extern uint32_t host_micros;
+static inline uint32_t micros(void) { return host_micros; }
+#ifndef constrain
+#define constrain(amt, low, high) ((amt) < (low) ? (low) : ((amt) > (high) ? (high) : (amt)))
+#endif
+/* the Monitor's printing, to stdout */
+struct HostSerial {
+  template <typename... Args> int printf(const char *format, Args... args) { return ::printf(format, args...); }
+  void println(const char *s = "") { ::puts(s); }
+};
+static HostSerial Serial __attribute__((unused));
+
+typedef struct audio_block_struct {
+  uint8_t  ref_count;
+  uint8_t  reserved1;
+  uint16_t memory_pool_index;
+  int16_t  data[AUDIO_BLOCK_SAMPLES];
+} audio_block_t;
+
+class AudioStream;
+
+class AudioConnection
+{
+ public:
+  AudioConnection(AudioStream &source, unsigned char sourceOutput,
+		  AudioStream &destination, unsigned char destinationInput);
+  AudioConnection(AudioStream &source, AudioStream &destination);
+ protected:
+  friend class AudioStream;
+  AudioStream &src;
+  AudioStream &dst;
+  unsigned char src_index;
+  unsigned char dest_index;
+  AudioConnection *next_dest;
+  void connect(void);
+};
+
+class AudioStream
+{
+ public:
+  AudioStream(unsigned char ninput, audio_block_t **iqueue) :
+    num_inputs(ninput), inputQueue(iqueue) {
+    active = true;
+    destination_list = NULL;
+    for (int i = 0; i < num_inputs; i += 1) inputQueue[i] = NULL;
+    cpu_cycles = cpu_cycles_max = cpu_cycles_total = 0;
+    next_update = NULL;
+    AudioStream **p = &first_update;
+    while (*p != NULL) p = &(*p)->next_update;
+    *p = this;
+  }
+  virtual ~AudioStream() {}
+  virtual void update(void) = 0;
+
+  /* run one block through every object */
+  static void update_all(void) {
+    uint64_t total = 0;
+    for (AudioStream *p = first_update; p != NULL; p = p->next_update) {
+      if ( ! p->active) continue;
+      uint64_t t0 = cycles();
+      p->update();
+      uint64_t c = cycles() - t0;
+      p->cpu_cycles = c;
+      if (c > p->cpu_cycles_max) p->cpu_cycles_max = c;
+      p->cpu_cycles_total += c;
+      total += c;
+    }
+    cpu_cycles_all = total;
+    if (total > cpu_cycles_all_max) cpu_cycles_all_max = total;
+  }
+  /* host cycles, the time stamp counter where there is one */
+  static uint64_t cycles(void) {
+#if defined(__x86_64__) || defined(__i386__)
+    return __rdtsc();
+#else
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ull + ts.tv_nsec;
+#endif
+  }
+
+  static void initialize_memory(unsigned int num) {
+    free(memory_pool);
+    memory_pool = (audio_block_t *)calloc(num, sizeof(audio_block_t));
+    memory_pool_size = num;
+    memory_used = memory_used_max = 0;
+    for (unsigned int i = 0; i < num; i += 1) {
+      memory_pool[i].memory_pool_index = i;
+      memory_pool[i].ref_count = 0;
+    }
+  }
+
+  bool active;
+  unsigned char num_inputs;
+  uint64_t cpu_cycles, cpu_cycles_max, cpu_cycles_total;
+  AudioStream *next_update;
+
+  static AudioStream *first_update;
+  static uint64_t cpu_cycles_all, cpu_cycles_all_max;
+  static audio_block_t *memory_pool;
+  static unsigned int memory_pool_size, memory_used, memory_used_max;
+
+ protected:
+  static audio_block_t *allocate(void) {
+    for (unsigned int i = 0; i < memory_pool_size; i += 1)
+      if (memory_pool[i].ref_count == 0) {
+	memory_pool[i].ref_count = 1;
+	if (++memory_used > memory_used_max) memory_used_max = memory_used;
+	return &memory_pool[i];
+      }
+    return NULL;
+  }
+  static void release(audio_block_t *block) {
+    if (block == NULL) return;
+    if (block->ref_count > 1) {
+      block->ref_count -= 1;
+    } else {
+      block->ref_count = 0;
+      memory_used -= 1;
+    }
+  }
+  void transmit(audio_block_t *block, unsigned char index = 0) {
+    for (AudioConnection *c = destination_list; c != NULL; c = c->next_dest) {
+      if (c->src_index != index) continue;
+      if (c->dst.inputQueue[c->dest_index] == NULL) {
+	c->dst.inputQueue[c->dest_index] = block;
+	block->ref_count += 1;
+      }
+    }
+  }
+  audio_block_t *receiveReadOnly(unsigned int index = 0) {
+    if (index >= num_inputs) return NULL;
+    audio_block_t *in = inputQueue[index];
+    inputQueue[index] = NULL;
+    return in;
+  }
+  audio_block_t *receiveWritable(unsigned int index = 0) {
+    audio_block_t *in = receiveReadOnly(index);
+    if (in != NULL && in->ref_count > 1) {
+      audio_block_t *p = allocate();
+      if (p != NULL) memcpy(p->data, in->data, sizeof(p->data));
+      in->ref_count -= 1;
+      in = p;
+    }
+    return in;
+  }
+
+ private:
+  friend class AudioConnection;
+  AudioConnection *destination_list;
+  audio_block_t **inputQueue;
+};
+
+inline AudioConnection::AudioConnection(AudioStream &source, unsigned char sourceOutput,
+					AudioStream &destination, unsigned char destinationInput) :
+  src(source), dst(destination), src_index(sourceOutput), dest_index(destinationInput) {
+  connect();
+}
+inline AudioConnection::AudioConnection(AudioStream &source, AudioStream &destination) :
+  src(source), dst(destination), src_index(0), dest_index(0) {
+  connect();
+}
+inline void AudioConnection::connect(void) {
+  next_dest = NULL;
+  AudioConnection **p = &src.destination_list;
+  while (*p != NULL) p = &(*p)->next_dest;
+  *p = this;
+}
+
+/* one definition of the statics per program, define AUDIO_STREAM_STATICS in one file */
+#ifdef AUDIO_STREAM_STATICS
+uint32_t host_micros;
+AudioStream *AudioStream::first_update;
+uint64_t AudioStream::cpu_cycles_all, AudioStream::cpu_cycles_all_max;
+audio_block_t *AudioStream::memory_pool;
+unsigned int AudioStream::memory_pool_size, AudioStream::memory_used, AudioStream::memory_used_max;
+#endif
+
+#define AudioMemory(num) AudioStream::initialize_memory(num)
+
+#endif // AudioStream_h
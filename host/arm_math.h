@@ -0,0 +1,86 @@
+/* -*- mode: c++; tab-width: 8 -*- */
+/*
+  Copyright (C) 2018 by Roger E Critchlow Jr, Charlestown, MA, USA.
+
+  This program is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation; either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program; if not, write to the Free Software
+  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307 USA
+*/
+/*
+** Scalar host versions of the CMSIS-DSP functions the sketch uses,
+** computing the same results as the Cortex-M4 library.
+*/
+#ifndef arm_math_h
+#define arm_math_h
+
+#include <stdint.h>
+
+typedef int8_t q7_t;
+typedef int16_t q15_t;
+typedef int32_t q31_t;
+typedef int64_t q63_t;
+typedef float float32_t;
+
+static inline q15_t __SSAT16(int32_t x) { return x > 32767 ? 32767 : x < -32768 ? -32768 : x; }
+
+static inline void arm_scale_q15(const q15_t *src, q15_t scaleFract, int8_t shift, q15_t *dst, uint32_t blockSize) {
+  int8_t kShift = 15 - shift;
+  for (uint32_t i = 0; i < blockSize; i += 1)
+    dst[i] = __SSAT16(((int32_t)src[i] * scaleFract) >> kShift);
+}
+
+static inline void arm_dot_prod_q15(const q15_t *a, const q15_t *b, uint32_t blockSize, q63_t *result) {
+  q63_t sum = 0;
+  for (uint32_t i = 0; i < blockSize; i += 1)
+    sum += (q31_t)a[i] * b[i];
+  *result = sum;
+}
+
+static inline void arm_power_q15(const q15_t *src, uint32_t blockSize, q63_t *result) {
+  arm_dot_prod_q15(src, src, blockSize, result);
+}
+
+typedef struct {
+  uint8_t M;
+  uint16_t numTaps;
+  const q15_t *pCoeffs;		/* time reversed, b[numTaps-1] first */
+  q15_t *pState;		/* numTaps+blockSize-1 */
+} arm_fir_decimate_instance_q15;
+
+typedef enum { ARM_MATH_SUCCESS = 0, ARM_MATH_LENGTH_ERROR = -2 } arm_status;
+
+static inline arm_status arm_fir_decimate_init_q15(arm_fir_decimate_instance_q15 *S, uint16_t numTaps, uint8_t M,
+						   const q15_t *pCoeffs, q15_t *pState, uint32_t blockSize) {
+  if (blockSize % M != 0) return ARM_MATH_LENGTH_ERROR;
+  S->M = M;
+  S->numTaps = numTaps;
+  S->pCoeffs = pCoeffs;
+  S->pState = pState;
+  for (uint32_t i = 0; i < numTaps + blockSize - 1; i += 1) pState[i] = 0;
+  return ARM_MATH_SUCCESS;
+}
+
+static inline void arm_fir_decimate_q15(const arm_fir_decimate_instance_q15 *S, const q15_t *src, q15_t *dst, uint32_t blockSize) {
+  q15_t *state = S->pState;
+  uint32_t taps = S->numTaps;
+  for (uint32_t i = 0; i < blockSize; i += 1) state[taps - 1 + i] = src[i];
+  for (uint32_t n = 0; n < blockSize / S->M; n += 1) {
+    q63_t sum = 0;
+    for (uint32_t k = 0; k < taps; k += 1)
+      sum += (q31_t)S->pCoeffs[k] * state[n * S->M + k];
+    dst[n] = __SSAT16((q31_t)(sum >> 15));
+  }
+  for (uint32_t i = 0; i < taps - 1; i += 1) state[i] = state[blockSize + i];
+}
+
+#endif // arm_math_h
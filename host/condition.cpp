@@ -0,0 +1,282 @@
+/* -*- mode: c++; tab-width: 8 -*- */
+/*
+  Copyright (C) 2018 by Roger E Critchlow Jr, Charlestown, MA, USA.
+
+  This program is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation; either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program; if not, write to the Free Software
+  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307 USA
+*/
+/*
+** Compare the fused microphone conditioner against the stock chain.
+**
+**   g++ -O2 -I host -I teensyduino/Pennywhistle host/condition.cpp -o condition
+**   ./condition [-s seconds]
+**
+** A simulated microphone, a DC offset, 30Hz rumble, and a 600Hz tone
+** which steps between -40dB and -6dB every two seconds, is fed, as
+** i2s1 is in the sketch, to the conditioner and two other readers.
+** Then the same through the stock way of doing it, a two stage
+** AudioFilterBiquad, an AudioAnalyzePeak, and an AudioAmplifier whose
+** gain is set from the peak once every 8 blocks, as loop() would.
+** The stock objects here are stand ins which do what the library's
+** do, in the same fixed point.  For each it reports the average host
+** cycles per block, the most pool blocks in use, the residual DC and
+** 30Hz, how far the 30Hz is under the 600Hz tone, the output peak
+** range over the settled halves of the loud and quiet steps, and the
+** largest block to block jump in the peak.
+*/
+#define AUDIO_STREAM_STATICS 1
+#include "Audio.h"
+#include "AudioConditionMic.h"
+
+#include <stdio.h>
+#include <unistd.h>
+
+/* the simulated microphone */
+class AudioMicHost : public AudioStream
+{
+ public:
+  AudioMicHost() : AudioStream(0, NULL), n(0) {}
+  virtual void update(void) {
+    audio_block_t *block = allocate();
+    if (block == NULL) return;
+    for (int i = 0; i < AUDIO_BLOCK_SAMPLES; i += 1, n += 1) {
+      double t = n / AUDIO_SAMPLE_RATE_EXACT;
+      double level = ((long)(t / 2) & 1) ? 0.5 : 0.01;
+      block->data[i] = 1500 + 3000 * sin(2 * M_PI * 30 * t) + 32767 * level * sin(2 * M_PI * 600 * t);
+    }
+    transmit(block);
+    release(block);
+  }
+  long n;
+};
+
+/* stands for breath1 and pitch1, holding a reference to the input */
+class AudioReadHost : public AudioStream
+{
+ public:
+  AudioReadHost() : AudioStream(1, inputQueueArray) {}
+  virtual void update(void) {
+    audio_block_t *block = receiveReadOnly();
+    if (block) release(block);
+  }
+ private:
+  audio_block_t *inputQueueArray[1];
+};
+
+/* the library's AudioFilterBiquad, direct form 1, Q30 coefficients */
+class AudioFilterBiquadHost : public AudioStream
+{
+ public:
+  AudioFilterBiquadHost() : AudioStream(1, inputQueueArray), stages(0) { memset(state, 0, sizeof(state)); }
+  void setHighpass(int stage, float hz, float q) {
+    double w = 2 * M_PI * hz / AUDIO_SAMPLE_RATE_EXACT, cw = cos(w), alpha = sin(w) / (2 * q), a0 = 1 + alpha;
+    int32_t *c = coef[stage];
+    c[0] = (1 + cw) / 2 / a0 * 1073741824.0;
+    c[1] = -(1 + cw) / a0 * 1073741824.0;
+    c[2] = c[0];
+    c[3] = -(-2 * cw / a0) * 1073741824.0;
+    c[4] = -((1 - alpha) / a0) * 1073741824.0;
+    if (stage >= stages) stages = stage + 1;
+  }
+  virtual void update(void) {
+    audio_block_t *block = receiveWritable();
+    if (block == NULL) return;
+    for (int s = 0; s < stages; s += 1) {
+      int32_t *c = coef[s], *st = state[s];
+      int32_t x1 = st[0], x2 = st[1], y1 = st[2], y2 = st[3];
+      for (int i = 0; i < AUDIO_BLOCK_SAMPLES; i += 1) {
+	int32_t x = block->data[i];
+	int64_t sum = (int64_t)c[0] * x + (int64_t)c[1] * x1 + (int64_t)c[2] * x2
+	  + (int64_t)c[3] * y1 + (int64_t)c[4] * y2;
+	int32_t y = sum >> 30;
+	x2 = x1; x1 = x; y2 = y1; y1 = y;
+	block->data[i] = y > 32767 ? 32767 : y < -32768 ? -32768 : y;
+      }
+      st[0] = x1; st[1] = x2; st[2] = y1; st[3] = y2;
+    }
+    transmit(block);
+    release(block);
+  }
+ private:
+  audio_block_t *inputQueueArray[1];
+  int32_t coef[4][5], state[4][4];
+  int stages;
+};
+
+/* the library's AudioAnalyzePeak */
+class AudioAnalyzePeakHost : public AudioStream
+{
+ public:
+  AudioAnalyzePeakHost() : AudioStream(1, inputQueueArray), lo(0), hi(0) {}
+  float read() {
+    int m = hi > -lo ? hi : -lo;
+    lo = hi = 0;
+    return m / 32767.0f;
+  }
+  virtual void update(void) {
+    audio_block_t *block = receiveReadOnly();
+    if (block == NULL) return;
+    for (int i = 0; i < AUDIO_BLOCK_SAMPLES; i += 1) {
+      if (block->data[i] < lo) lo = block->data[i];
+      if (block->data[i] > hi) hi = block->data[i];
+    }
+    release(block);
+  }
+ private:
+  audio_block_t *inputQueueArray[1];
+  int16_t lo, hi;
+};
+
+/* the library's AudioAmplifier, Q16 gain */
+class AudioAmplifierHost : public AudioStream
+{
+ public:
+  AudioAmplifierHost() : AudioStream(1, inputQueueArray), mult(65536) {}
+  void gain(float g) { mult = g * 65536.0f; }
+  virtual void update(void) {
+    audio_block_t *block = receiveWritable();
+    if (block == NULL) return;
+    if (mult != 65536)
+      for (int i = 0; i < AUDIO_BLOCK_SAMPLES; i += 1) {
+	int32_t y = ((int64_t)block->data[i] * mult) >> 16;
+	block->data[i] = y > 32767 ? 32767 : y < -32768 ? -32768 : y;
+      }
+    transmit(block);
+    release(block);
+  }
+ private:
+  audio_block_t *inputQueueArray[1];
+  int32_t mult;
+};
+
+/* measures the output, after the first second */
+class AudioMeasureHost : public AudioStream
+{
+ public:
+  AudioMeasureHost(AudioMicHost &mic) : AudioStream(1, inputQueueArray), mic(mic) { reset(); }
+  void reset() {
+    sum = 0; count = 0; rumble_i = rumble_q = tone_i = tone_q = 0;
+    for (int i = 0; i < 2; i += 1) { lo[i] = 1e9; hi[i] = 0; }
+    last = -1; jump = 0;
+  }
+  virtual void update(void) {
+    audio_block_t *block = receiveReadOnly();
+    if (block == NULL) return;
+    long n0 = mic.n - AUDIO_BLOCK_SAMPLES;
+    double peak = 0;
+    for (int i = 0; i < AUDIO_BLOCK_SAMPLES; i += 1) {
+      double t = (n0 + i) / AUDIO_SAMPLE_RATE_EXACT, y = block->data[i];
+      sum += y;
+      rumble_i += y * cos(2 * M_PI * 30 * t);
+      rumble_q += y * sin(2 * M_PI * 30 * t);
+      tone_i += y * cos(2 * M_PI * 600 * t);
+      tone_q += y * sin(2 * M_PI * 600 * t);
+      if (fabs(y) > peak) peak = fabs(y);
+    }
+    count += AUDIO_BLOCK_SAMPLES;
+    double t = n0 / AUDIO_SAMPLE_RATE_EXACT, phase = fmod(t, 2);
+    double end = 2 - AUDIO_BLOCK_SAMPLES / AUDIO_SAMPLE_RATE_EXACT;
+    if (t > 1 && phase > 1 && phase < end) {	// the settled second half of each step
+      int loud = ((long)(t / 2) & 1);
+      if (peak < lo[loud]) lo[loud] = peak;
+      if (peak > hi[loud]) hi[loud] = peak;
+    }
+    if (t > 1 && last >= 0 && fabs(peak - last) > jump) jump = fabs(peak - last);
+    last = peak;
+    release(block);
+  }
+  double dc() { return sum / count; }
+  double rumble() { return 2 * sqrt(rumble_i * rumble_i + rumble_q * rumble_q) / count; }
+  double tone() { return 2 * sqrt(tone_i * tone_i + tone_q * tone_q) / count; }
+  AudioMicHost &mic;
+  double sum, rumble_i, rumble_q, tone_i, tone_q, lo[2], hi[2], last, jump;
+  long count;
+ private:
+  audio_block_t *inputQueueArray[1];
+};
+
+AudioMicHost             mic1;
+AudioConditionMic        cond1;
+AudioReadHost            read1, read2;
+AudioMeasureHost         measure1(mic1);
+AudioConnection          patchCord1(mic1, 0, cond1, 0);
+AudioConnection          patchCord2(mic1, 0, read1, 0);
+AudioConnection          patchCord3(mic1, 0, read2, 0);
+AudioConnection          patchCord4(cond1, 0, measure1, 0);
+
+AudioMicHost             mic2;
+AudioFilterBiquadHost    biquad2;
+AudioAnalyzePeakHost     peak2;
+AudioAmplifierHost       amp2;
+AudioReadHost            read3, read4;
+AudioMeasureHost         measure2(mic2);
+AudioConnection          patchCord5(mic2, 0, biquad2, 0);
+AudioConnection          patchCord6(mic2, 0, read3, 0);
+AudioConnection          patchCord7(mic2, 0, read4, 0);
+AudioConnection          patchCord8(biquad2, 0, peak2, 0);
+AudioConnection          patchCord9(biquad2, 0, amp2, 0);
+AudioConnection          patchCord10(amp2, 0, measure2, 0);
+
+static void report(const char *name, AudioStream **nodes, AudioMeasureHost &m, long nblocks) {
+  uint64_t total = 0;
+  for (AudioStream **p = nodes; *p != NULL; p += 1) total += (*p)->cpu_cycles_total;
+  printf("%-6s %6.0f cycles per block, %u pool blocks at most\n", name,
+	 (double)total / nblocks, AudioStream::memory_used_max);
+  printf("       dc %.1f, 30Hz %.1f, %.1fdB under 600Hz\n", m.dc(), m.rumble(), 20 * log10(m.tone() / m.rumble()));
+  printf("       quiet peak %.0f to %.0f, loud peak %.0f to %.0f, largest jump %.0f\n",
+	 m.lo[0], m.hi[0], m.lo[1], m.hi[1], m.jump);
+}
+
+int main(int argc, char *argv[]) {
+  float seconds = 20;
+  int c;
+  while ((c = getopt(argc, argv, "s:")) != -1) {
+    if (c == 's') seconds = atof(optarg);
+    else {
+      fprintf(stderr, "usage: %s [-s seconds]\n", argv[0]);
+      return 1;
+    }
+  }
+  const long nblocks = seconds * AUDIO_SAMPLE_RATE_EXACT / AUDIO_BLOCK_SAMPLES;
+  AudioStream *fused[] = { &cond1, NULL };
+  AudioStream *stock[] = { &biquad2, &peak2, &amp2, NULL };
+  AudioStream *one[] = { &mic1, &cond1, &read1, &read2, &measure1, NULL };
+  AudioStream *two[] = { &mic2, &biquad2, &peak2, &amp2, &read3, &read4, &measure2, NULL };
+
+  // the same fourth order high pass as the conditioner, which takes the dc too
+  biquad2.setHighpass(0, 80, 0.5412f);
+  biquad2.setHighpass(1, 80, 1.3066f);
+
+  // the fused conditioner alone
+  for (AudioStream **p = two; *p != NULL; p += 1) (*p)->active = false;
+  AudioMemory(16);
+  for (long b = 0; b < nblocks; b += 1) AudioStream::update_all();
+  report("fused", fused, measure1, nblocks);
+
+  // the stock chain alone, the loop's agc every 8 blocks, 23ms
+  for (AudioStream **p = one; *p != NULL; p += 1) (*p)->active = false;
+  for (AudioStream **p = two; *p != NULL; p += 1) (*p)->active = true;
+  AudioMemory(16);
+  float g = 1, env = 0;
+  for (long b = 0; b < nblocks; b += 1) {
+    AudioStream::update_all();
+    if ((b & 7) != 7) continue;
+    float p = peak2.read();
+    env = p > env ? p : env + (p - env) * 0.1f;
+    if (env > 0.001f) g += (constrain(0.25f / env, 0.25f, 16.0f) - g) / 2;
+    amp2.gain(g);
+  }
+  report("stock", stock, measure2, nblocks);
+  return 0;
+}
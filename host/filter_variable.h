@@ -0,0 +1,91 @@
+/* -*- mode: c++; tab-width: 8 -*- */
+/*
+  Copyright (C) 2018 by Roger E Critchlow Jr, Charlestown, MA, USA.
+
+  This program is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation; either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program; if not, write to the Free Software
+  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307 USA
+*/
+/*
+** Host stand in for the Teensy Audio library's
+** AudioFilterStateVariable, the same twice oversampled Chamberlin
+** filter in the same fixed point, with a fixed frequency, no
+** control input.  Outputs are lowpass, bandpass and highpass.
+*/
+#ifndef filter_variable_h_
+#define filter_variable_h_
+
+#include "AudioStream.h"
+
+class AudioFilterStateVariable : public AudioStream
+{
+ public:
+  AudioFilterStateVariable() : AudioStream(2, inputQueueArray) {
+    frequency(1000);
+    resonance(0.707);
+    _lowpass = _bandpass = _inputprev = 0;
+  }
+  void frequency(float freq) {
+    if (freq < 20.0f) freq = 20.0f;
+    else if (freq > AUDIO_SAMPLE_RATE_EXACT / 2.5f) freq = AUDIO_SAMPLE_RATE_EXACT / 2.5f;
+    _fmult = sinf(freq * (3.141592654f / (AUDIO_SAMPLE_RATE_EXACT * 2.0f))) * 2147483647.0f;
+  }
+  void resonance(float q) {
+    if (q < 0.7f) q = 0.7f;
+    else if (q > 5.0f) q = 5.0f;
+    _damp = (1.0f / q) * 1073741824.0f;
+  }
+
+  virtual void update(void) {
+    audio_block_t *in = receiveReadOnly(0);
+    audio_block_t *control = receiveReadOnly(1);
+    if (control != NULL) release(control);
+    if (in == NULL) return;
+    audio_block_t *lp = allocate(), *bp = allocate(), *hp = allocate();
+    if (lp == NULL || bp == NULL || hp == NULL) {
+      release(lp); release(bp); release(hp); release(in);
+      return;
+    }
+    int32_t lowpass = _lowpass, bandpass = _bandpass, inputprev = _inputprev, highpass;
+    for (int n = 0; n < AUDIO_BLOCK_SAMPLES; n += 1) {
+      int32_t input = in->data[n] << 12;
+      lowpass += mult(_fmult, bandpass);
+      highpass = ((input + inputprev) >> 1) - lowpass - mult(_damp, bandpass);
+      inputprev = input;
+      bandpass += mult(_fmult, highpass);
+      int32_t lowpasstmp = lowpass, bandpasstmp = bandpass, highpasstmp = highpass;
+      lowpass += mult(_fmult, bandpass);
+      highpass = input - lowpass - mult(_damp, bandpass);
+      bandpass += mult(_fmult, highpass);
+      lp->data[n] = sat16((lowpass + lowpasstmp) >> 13);
+      bp->data[n] = sat16((bandpass + bandpasstmp) >> 13);
+      hp->data[n] = sat16((highpass + highpasstmp) >> 13);
+    }
+    _lowpass = lowpass; _bandpass = bandpass; _inputprev = inputprev;
+    release(in);
+    transmit(lp, 0); release(lp);
+    transmit(bp, 1); release(bp);
+    transmit(hp, 2); release(hp);
+  }
+
+ private:
+  /* the library's multiply_32x32_rshift32_rounded() << 1 */
+  static inline int32_t mult(int32_t a, int32_t b) { return (int32_t)(((int64_t)a * b + 0x80000000ll) >> 32) << 1; }
+  static inline int16_t sat16(int32_t x) { return x > 32767 ? 32767 : x < -32768 ? -32768 : x; }
+
+  audio_block_t *inputQueueArray[2];
+  int32_t _fmult, _damp;
+  int32_t _lowpass, _bandpass, _inputprev;
+};
+
+#endif
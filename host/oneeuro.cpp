@@ -0,0 +1,192 @@
+/* -*- mode: c++; tab-width: 8 -*- */
+/*
+  Copyright (C) 2018 by Roger E Critchlow Jr, Charlestown, MA, USA.
+
+  This program is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation; either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program; if not, write to the Free Software
+  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307 USA
+*/
+/*
+** Measure the lag and jitter of the breath smoothing.
+**
+**   g++ -O2 -I host -I teensyduino/Pennywhistle host/oneeuro.cpp -o oneeuro
+**   ./oneeuro [-m min cutoff] [-b beta] [-d derivative cutoff] [trace ...]
+**
+** A trace has lines of "<ms> breath <level>", as for host/render.cpp,
+** the barometer's breath level, 0 to 1, and the time it was read, as
+** the Monitor's P stream prints them.
+** Without traces, one is made up: a minute of phrases, 40ms attacks
+** and 60ms releases around held notes which swell slowly, read at
+** 25Hz with 0.4% of full scale noise, as the BMP280 does, so the
+** true breath is known.  For a recorded trace the reference is a
+** centered, zero lag, average of 7 readings.
+**
+** Each trace is run through the raw readings, a plain one pole at
+** 2, 5, and 10Hz, and the One Euro filter with the given settings,
+** defaults from Config.h.  For each it reports
+**   lag    - the average and worst time from the reference crossing
+**            0.25 to the output crossing it the same way, in ms
+**   jitter - the rms of the output less the reference, less its
+**            local mean, while the reference holds within 0.08 above
+**            0.25, from half a second after the attack
+*/
+#include "AudioStream.h"
+#include "Config.h"
+#include "OneEuroFilter.h"
+
+#include <stdio.h>
+#include <unistd.h>
+#include <vector>
+
+uint32_t host_micros;
+
+struct Sample { uint32_t us; float x, ref; };
+
+static const float EDGE = 0.25f;
+static const uint32_t SETTLE = 500000;	/* us after an edge before jitter counts */
+
+static bool read_trace(const char *file, std::vector<Sample> &trace) {
+  FILE *fp = fopen(file, "r");
+  if (fp == NULL) { perror(file); return false; }
+  char line[256];
+  double ms;
+  float x;
+  while (fgets(line, sizeof(line), fp) != NULL)
+    if (sscanf(line, "%lf breath %f", &ms, &x) == 2) trace.push_back({ (uint32_t)(ms * 1000), x, 0 });
+  fclose(fp);
+  if (trace.size() < 8) {
+    fprintf(stderr, "%s: too few breath lines\n", file);
+    return false;
+  }
+  for (size_t i = 0; i < trace.size(); i += 1) {
+    size_t lo = i < 3 ? 0 : i - 3, hi = std::min(trace.size() - 1, i + 3);
+    float sum = 0;
+    for (size_t j = lo; j <= hi; j += 1) sum += trace[j].x;
+    trace[i].ref = sum / (hi - lo + 1);
+  }
+  return true;
+}
+
+/* the true breath at t seconds, and the phrases */
+static float breath(double t) {
+  static const double period = 2.1;
+  double p = fmod(t, period), n = floor(t / period);
+  double level = 0.45 + 0.4 * fmod(n * 0.618, 1.0);
+  double swell = 1 + 0.15 * sin(M_PI * p / 1.6);
+  if (p < 0.04) return level * p / 0.04;
+  if (p < 1.6) return level * (p < 0.2 ? 1 : swell);
+  if (p < 1.66) return level * (1.66 - p) / 0.06;
+  return 0;
+}
+
+static void make_trace(std::vector<Sample> &trace) {
+  uint32_t seed = 12345;
+  double t = 0;
+  while (t < 60) {
+    float noise = 0;
+    for (int i = 0; i < 12; i += 1) {	/* near gaussian */
+      seed = seed * 1664525 + 1013904223;
+      noise += (seed >> 8) / 16777216.0f;
+    }
+    float truth = breath(t);
+    trace.push_back({ (uint32_t)(t * 1e6), truth + 0.004f * (noise - 6), truth });
+    seed = seed * 1664525 + 1013904223;
+    t += 0.038 + 0.004 * (seed >> 8) / 16777216.0;	/* 25Hz, wandering */
+  }
+}
+
+static void measure(const char *name, const std::vector<Sample> &trace, OneEuroFilter *f) {
+  std::vector<float> out(trace.size());
+  for (size_t i = 0; i < trace.size(); i += 1)
+    out[i] = f ? f->filter(trace[i].x, trace[i].us) : trace[i].x;
+  double lag_sum = 0, lag_max = 0, jit_sum = 0;
+  int edges = 0, steady = 0;
+  uint32_t last_edge = 0;
+  for (size_t i = 1; i < trace.size(); i += 1) {
+    int up = trace[i-1].ref < EDGE && trace[i].ref >= EDGE;
+    int down = trace[i-1].ref >= EDGE && trace[i].ref < EDGE;
+    if (up || down) {
+      // where the reference crossed, interpolated, then where the output did
+      double a = trace[i-1].ref - EDGE, b = trace[i].ref - EDGE;
+      double t0 = trace[i-1].us + (trace[i].us - trace[i-1].us) * a / (a - b);
+      last_edge = trace[i].us;
+      for (size_t j = i; j < trace.size() && j < i + 50; j += 1)
+	if (up ? out[j] >= EDGE : out[j] < EDGE) {
+	  double lag = (trace[j].us - t0) / 1000;
+	  lag_sum += lag;
+	  if (lag > lag_max) lag_max = lag;
+	  edges += 1;
+	  break;
+	}
+    }
+    if (i >= 5 && i + 5 < trace.size() && trace[i].ref > EDGE && trace[i-5].us > last_edge + SETTLE) {
+      float lo = trace[i].ref, hi = lo;
+      for (size_t j = i-5; j <= i+5; j += 1) {
+	lo = std::min(lo, trace[j].ref);
+	hi = std::max(hi, trace[j].ref);
+      }
+      if (hi - lo < 0.08f && lo > EDGE) {
+	// the error less its local mean, so slow tracking error isn't counted
+	double mean = 0;
+	for (size_t j = i-5; j <= i+5; j += 1) mean += out[j] - trace[j].ref;
+	double e = out[i] - trace[i].ref - mean / 11;
+	jit_sum += e * e;
+	steady += 1;
+      }
+    }
+  }
+  printf("%-24s lag %5.1fms avg %5.1fms max, jitter %6.4f rms\n", name,
+	 edges ? lag_sum / edges : 0, lag_max, steady ? sqrt(jit_sum / steady) : 0);
+}
+
+int main(int argc, char *argv[]) {
+  float m = BREATH_EURO_MIN_CUTOFF, b = BREATH_EURO_BETA, d = BREATH_EURO_D_CUTOFF;
+  int c;
+  while ((c = getopt(argc, argv, "m:b:d:")) != -1) {
+    switch (c) {
+    case 'm': m = atof(optarg); break;
+    case 'b': b = atof(optarg); break;
+    case 'd': d = atof(optarg); break;
+    default:
+      fprintf(stderr, "usage: %s [-m min cutoff] [-b beta] [-d derivative cutoff] [trace ...]\n", argv[0]);
+      return 1;
+    }
+  }
+  for (int arg = optind; arg <= argc; arg += 1) {
+    std::vector<Sample> trace;
+    if (arg < argc) {
+      if ( ! read_trace(argv[arg], trace)) continue;
+      printf("%s: %zu readings\n", argv[arg], trace.size());
+    } else if (optind == argc) {
+      make_trace(trace);
+      printf("made up: %zu readings\n", trace.size());
+    } else break;
+    measure("raw", trace, NULL);
+    for (float hz : { 2.0f, 5.0f, 10.0f }) {
+      OneEuroFilter f;
+      f.minCutoff(hz);
+      f.beta(0);
+      char name[64];
+      snprintf(name, sizeof(name), "one pole %.0fHz", hz);
+      measure(name, trace, &f);
+    }
+    OneEuroFilter f;
+    f.minCutoff(m);
+    f.beta(b);
+    f.derivativeCutoff(d);
+    char name[64];
+    snprintf(name, sizeof(name), "one euro %.2g %.2g %.2g", m, b, d);
+    measure(name, trace, &f);
+  }
+  return 0;
+}
@@ -0,0 +1,143 @@
+/* -*- mode: c++; tab-width: 8 -*- */
+/*
+  Copyright (C) 2018 by Roger E Critchlow Jr, Charlestown, MA, USA.
+
+  This program is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation; either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program; if not, write to the Free Software
+  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307 USA
+*/
+/*
+** Run the sketch's pitch tracker over recorded WAV files on Linux.
+**
+**   g++ -O2 -I host -I teensyduino/Pennywhistle host/pitch.cpp -o pitch
+**   ./pitch [-q] file.wav ...
+**
+** Each file, 16 bit PCM, the first channel if there are more, is fed
+** block by block through AudioAnalyzePitch.  Each estimate is printed
+** with its time, frequency, probability, and the nearest note and
+** cents, unless -q, then the host cycles per block, average and peak,
+** are reported.  Files at other rates than the Teensy's are analyzed
+** as they are and the frequencies scaled to the file's rate.
+*/
+#define AUDIO_STREAM_STATICS 1
+#include "Audio.h"
+#include "AudioAnalyzePitch.h"
+
+#include <stdio.h>
+#include <unistd.h>
+#include <vector>
+#include <algorithm>
+
+static const char *names[] = { "C", "C#", "D", "D#", "E", "F", "F#", "G", "G#", "A", "A#", "B" };
+
+/* plays the samples, then silence */
+class AudioPlayHost : public AudioStream
+{
+ public:
+  AudioPlayHost() : AudioStream(0, NULL), next(0) {}
+  virtual void update(void) {
+    audio_block_t *block = allocate();
+    if (block == NULL) return;
+    for (int n = 0; n < AUDIO_BLOCK_SAMPLES; n += 1, next += 1)
+      block->data[n] = next < samples.size() ? samples[next] : 0;
+    transmit(block);
+    release(block);
+  }
+  std::vector<int16_t> samples;
+  size_t next;
+};
+
+static uint32_t get32(const uint8_t *p) { return p[0] | (p[1] << 8) | (p[2] << 16) | ((uint32_t)p[3] << 24); }
+static uint16_t get16(const uint8_t *p) { return p[0] | (p[1] << 8); }
+
+/* 16 bit PCM samples of the first channel, and the sample rate */
+static bool read_wav(const char *file, std::vector<int16_t> &samples, uint32_t &rate) {
+  FILE *fp = fopen(file, "rb");
+  if (fp == NULL) { perror(file); return false; }
+  std::vector<uint8_t> buf;
+  uint8_t chunk[4096];
+  size_t n;
+  while ((n = fread(chunk, 1, sizeof(chunk), fp)) > 0) buf.insert(buf.end(), chunk, chunk+n);
+  fclose(fp);
+  if (buf.size() < 12 || memcmp(&buf[0], "RIFF", 4) != 0 || memcmp(&buf[8], "WAVE", 4) != 0) {
+    fprintf(stderr, "%s: not a WAV file\n", file);
+    return false;
+  }
+  uint16_t format = 0, channels = 0, bits = 0;
+  for (size_t i = 12; i + 8 <= buf.size(); ) {
+    uint32_t size = get32(&buf[i+4]);
+    const uint8_t *body = &buf[i+8];
+    if (memcmp(&buf[i], "fmt ", 4) == 0 && size >= 16) {
+      format = get16(body);
+      channels = get16(body+2);
+      rate = get32(body+4);
+      bits = get16(body+14);
+    } else if (memcmp(&buf[i], "data", 4) == 0 && channels != 0) {
+      if (format != 1 || bits != 16) {
+	fprintf(stderr, "%s: only 16 bit PCM\n", file);
+	return false;
+      }
+      size = std::min<size_t>(size, buf.size() - (i+8));
+      for (uint32_t j = 0; j + 2*channels <= size; j += 2*channels)
+	samples.push_back((int16_t)get16(body+j));
+      return true;
+    }
+    i += 8 + size + (size & 1);
+  }
+  fprintf(stderr, "%s: no data\n", file);
+  return false;
+}
+
+AudioPlayHost            play1;
+AudioAnalyzePitch        pitch1;
+AudioConnection          patchCord1(play1, 0, pitch1, 0);
+
+int main(int argc, char *argv[]) {
+  int quiet = 0, c;
+  while ((c = getopt(argc, argv, "q")) != -1) {
+    if (c == 'q') quiet = 1;
+    else optind = argc;
+  }
+  if (optind >= argc) {
+    fprintf(stderr, "usage: %s [-q] file.wav ...\n", argv[0]);
+    return 1;
+  }
+  AudioMemory(8);
+  for (int f = optind; f < argc; f += 1) {
+    uint32_t rate = 0;
+    play1.samples.clear();
+    play1.next = 0;
+    if ( ! read_wav(argv[f], play1.samples, rate)) continue;
+    float scale = rate / AUDIO_SAMPLE_RATE_EXACT;
+    long nblocks = play1.samples.size() / AUDIO_BLOCK_SAMPLES + AudioAnalyzePitch::STEPS * 2;
+    uint64_t total = 0, peak = 0;
+    int estimates = 0;
+    printf("%s: %u Hz, %.2f seconds\n", argv[f], rate, (float)play1.samples.size() / rate);
+    for (long b = 0; b < nblocks; b += 1) {
+      AudioStream::update_all();
+      total += pitch1.cpu_cycles;
+      if (pitch1.cpu_cycles > peak) peak = pitch1.cpu_cycles;
+      if ( ! pitch1.available()) continue;
+      float hz = pitch1.read() * scale;
+      estimates += 1;
+      if (quiet) continue;
+      float note = 69 + 12 * log2f(hz / 440.0f);
+      int n = lroundf(note);
+      printf("%8.3f s %8.2f Hz %4.2f  %-2s%d %+5.1f cents\n", (float)(b + 1) * AUDIO_BLOCK_SAMPLES / rate,
+	     hz, pitch1.probability(), names[n % 12], n / 12 - 1, 100 * (note - n));
+    }
+    printf("%d estimates, %.0f cycles per block average, %llu peak\n", estimates,
+	   (double)total / nblocks, (unsigned long long)peak);
+  }
+  return 0;
+}
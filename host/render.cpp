@@ -0,0 +1,238 @@
+/* -*- mode: c++; tab-width: 8 -*- */
+/*
+  Copyright (C) 2018 by Roger E Critchlow Jr, Charlestown, MA, USA.
+
+  This program is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation; either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program; if not, write to the Free Software
+  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307 USA
+*/
+/*
+** Render the sketch's synth voices on Linux, faster than realtime.
+**
+**   g++ -O2 -I host -I teensyduino/Pennywhistle host/render.cpp -o render
+**   ./render [-v voice] [-o out.wav] [-s seconds] [trace]
+**
+** The voices are built as in the sketch and selected by -v as a
+** program change would: 0, the default, the waveguide whistle,
+** 1 the sawtooth reed through the host stand ins for the library's
+** waveform and state variable filter, see host/Audio.h.
+**
+** The trace is text, one event per line, blank lines and # comments
+** ignored, the time in milliseconds from the start:
+**   <ms> note <midi note>     fingered note, 255 for no note
+**   <ms> breath <0..1>        breath level
+** Without a trace a two octave D major scale is played.
+**
+** Events are posted to the whistle's event queue stamped with their
+** trace time, and the clock the voice sees is advanced a block at a
+** time, so they land at their sample offsets as on the Teensy.  The
+** reed takes them at the next block, as the library objects do.
+** The audio objects run block by block outside any interrupt,
+** the output goes to a 16 bit mono WAV file, and the cost is reported
+** as blocks per second, host cycles per sample, and the peak cost of
+** a block, overall and for each object.
+*/
+#define AUDIO_STREAM_STATICS 1
+#include "Audio.h"
+#include "Config.h"
+#include "Midi.h"
+#include "AudioSynthWaveguide.h"
+#include "AudioAmplifierRamp.h"
+#include "AudioVoiceSwitch.h"
+
+#include <stdio.h>
+#include <unistd.h>
+#include <vector>
+
+/* collects the rendered samples */
+class AudioRecordHost : public AudioStream
+{
+ public:
+  AudioRecordHost() : AudioStream(1, inputQueueArray) {}
+  virtual void update(void) {
+    audio_block_t *block = receiveReadOnly();
+    if (block == NULL) {
+      samples.insert(samples.end(), AUDIO_BLOCK_SAMPLES, 0);
+      return;
+    }
+    samples.insert(samples.end(), block->data, block->data+AUDIO_BLOCK_SAMPLES);
+    release(block);
+  }
+  std::vector<int16_t> samples;
+ private:
+  audio_block_t *inputQueueArray[1];
+};
+
+AudioSynthWaveguideFlute flute1;
+AudioSynthWaveform       wave1;
+AudioFilterStateVariable filt1;
+AudioAmplifierRamp       amp3;
+AudioVoiceSwitch         voice1;
+AudioRecordHost          rec1;
+AudioConnection          patchCord5(flute1, 0, voice1, 0);
+AudioConnection          patchCord7(wave1, 0, filt1, 0);
+AudioConnection          patchCord8(filt1, 0, amp3, 0);
+AudioConnection          patchCord13(amp3, 0, voice1, 1);
+AudioConnection          patchCord9(voice1, 0, rec1, 0);
+
+static const struct { AudioStream *object; const char *name; } objects[] = {
+  { &flute1, "flute1" }, { &wave1, "wave1" }, { &filt1, "filt1" },
+  { &amp3, "amp3" }, { &voice1, "voice1" }, { &rec1, "rec1" }
+};
+
+struct event { float ms; char kind; float value; };
+
+static std::vector<event> read_trace(const char *file) {
+  std::vector<event> events;
+  FILE *fp = fopen(file, "r");
+  if (fp == NULL) { perror(file); exit(1); }
+  char line[256], kind[32];
+  float ms, value;
+  while (fgets(line, sizeof(line), fp) != NULL) {
+    if (line[0] == '#' || sscanf(line, "%f %31s %f", &ms, kind, &value) != 3) continue;
+    if (strcmp(kind, "note") == 0) events.push_back({ ms, 'n', value });
+    else if (strcmp(kind, "breath") == 0) events.push_back({ ms, 'b', value });
+    else fprintf(stderr, "%s: unknown event %s\n", file, kind);
+  }
+  fclose(fp);
+  return events;
+}
+
+static std::vector<event> default_trace(void) {
+  static const int steps[] = { 0, 2, 4, 5, 7, 9, 11, 12, 14, 16, 17, 19, 21, 23, 24 };
+  std::vector<event> events;
+  float ms = 0;
+  events.push_back({ ms, 'b', 0.7f });
+  for (int step : steps) {
+    events.push_back({ ms, 'n', (float)(Midi::D + step) });
+    ms += 250;
+  }
+  events.push_back({ ms, 'b', 0.0f });
+  events.push_back({ ms, 'n', 255 });
+  return events;
+}
+
+/* as voice_note() and voice_breath() in the sketch */
+static uint8_t voice = 0;
+static bool reed_note = false;
+static float reed_breath = 0;
+
+static void post(const event &e) {
+  uint32_t stamp = e.ms * 1000;
+  bool on = e.value >= 0 && e.value < 128;
+  switch (e.kind) {
+  case 'n':
+    if (voice == 0 && on)
+      flute1.events.post(stamp, SynthEvents::NOTE_ON, Midi::frequency(e.value));
+    else if (voice == 0)
+      flute1.events.post(stamp, SynthEvents::NOTE_OFF);
+    else {
+      if (on) {
+	wave1.frequency(Midi::frequency(e.value));
+	wave1.amplitude(1.0);
+      }
+      reed_note = on;
+      amp3.gain(on ? reed_breath : 0);
+    }
+    break;
+  case 'b':
+    if (voice == 0)
+      flute1.events.post(stamp, SynthEvents::BREATH, e.value);
+    else {
+      reed_breath = e.value;
+      if (reed_note) amp3.gain(e.value);
+      filt1.frequency(300 + 3000 * e.value);
+    }
+    break;
+  }
+}
+
+static void put16(FILE *fp, uint16_t v) { fputc(v & 0xFF, fp); fputc(v >> 8, fp); }
+static void put32(FILE *fp, uint32_t v) { put16(fp, v & 0xFFFF); put16(fp, v >> 16); }
+
+static void write_wav(const char *file, const std::vector<int16_t> &samples) {
+  FILE *fp = fopen(file, "wb");
+  if (fp == NULL) { perror(file); exit(1); }
+  uint32_t rate = AUDIO_SAMPLE_RATE_EXACT + 0.5f, bytes = 2 * samples.size();
+  fwrite("RIFF", 1, 4, fp); put32(fp, 36 + bytes); fwrite("WAVE", 1, 4, fp);
+  fwrite("fmt ", 1, 4, fp); put32(fp, 16); put16(fp, 1); put16(fp, 1);
+  put32(fp, rate); put32(fp, 2 * rate); put16(fp, 2); put16(fp, 16);
+  fwrite("data", 1, 4, fp); put32(fp, bytes);
+  for (int16_t s : samples) put16(fp, s);
+  fclose(fp);
+}
+
+int main(int argc, char *argv[]) {
+  const char *out = "render.wav";
+  float seconds = 0;
+  int c;
+  while ((c = getopt(argc, argv, "v:o:s:")) != -1) {
+    switch (c) {
+    case 'v': voice = atoi(optarg); break;
+    case 'o': out = optarg; break;
+    case 's': seconds = atof(optarg); break;
+    default:
+      fprintf(stderr, "usage: %s [-v voice] [-o out.wav] [-s seconds] [trace]\n", argv[0]);
+      return 1;
+    }
+  }
+  if (voice > 1) {
+    fprintf(stderr, "%s: voice 0 is the whistle, 1 the reed\n", argv[0]);
+    return 1;
+  }
+  std::vector<event> events = optind < argc ? read_trace(argv[optind]) : default_trace();
+  if (seconds == 0) seconds = (events.empty() ? 0 : events.back().ms / 1000) + 1;
+
+  AudioMemory(16);
+  // the sketch's setup() and program change, without the crossfade
+  wave1.begin(0.0, 440.0, WAVEFORM_SAWTOOTH);
+  filt1.resonance(1.0);
+  amp3.gain(0.0);
+  voice1.fadeBlocks(1);
+  voice1.select(voice);
+  const float ms_per_block = 1000.0f * AUDIO_BLOCK_SAMPLES / AUDIO_SAMPLE_RATE_EXACT;
+  const long nblocks = seconds * 1000 / ms_per_block;
+  rec1.samples.reserve(nblocks * AUDIO_BLOCK_SAMPLES);
+  size_t next = 0;
+  struct timespec t0, t1;
+  clock_gettime(CLOCK_MONOTONIC, &t0);
+  for (long b = 0; b < nblocks; b += 1) {
+    // the block is computed when its span of input has been acquired
+    float now = (b + 1) * ms_per_block;
+    while (next < events.size() && events[next].ms < now) post(events[next++]);
+    host_micros = now * 1000;
+    AudioStream::update_all();
+  }
+  clock_gettime(CLOCK_MONOTONIC, &t1);
+  write_wav(out, rec1.samples);
+
+  double elapsed = (t1.tv_sec - t0.tv_sec) + (t1.tv_nsec - t0.tv_nsec) * 1e-9;
+  double realtime = AUDIO_SAMPLE_RATE_EXACT / AUDIO_BLOCK_SAMPLES;
+  printf("%s: %ld blocks, %.1f seconds of audio\n", out, nblocks, nblocks / realtime);
+  printf("%.0f blocks/second, %.1fx realtime\n", nblocks / elapsed, nblocks / elapsed / realtime);
+  printf("%-12s %14s %12s\n", "object", "cycles/sample", "peak/block");
+  uint64_t total = 0;
+  for (AudioStream *p = AudioStream::first_update; p != NULL; p = p->next_update) {
+    const char *name = "?";
+    for (auto &o : objects) if (o.object == p) name = o.name;
+    printf("%-12s %14.1f %12llu\n", name,
+	   (double)p->cpu_cycles_total / (nblocks * AUDIO_BLOCK_SAMPLES), (unsigned long long)p->cpu_cycles_max);
+    total += p->cpu_cycles_total;
+  }
+  printf("%-12s %14.1f %12llu\n", "all",
+	 (double)total / (nblocks * AUDIO_BLOCK_SAMPLES), (unsigned long long)AudioStream::cpu_cycles_all_max);
+  if (flute1.events.late() || flute1.events.dropped())
+    printf("events late %u, dropped %u\n", flute1.events.late(), flute1.events.dropped());
+  printf("audio memory used max %u of %u blocks\n", AudioStream::memory_used_max, AudioStream::memory_pool_size);
+  return 0;
+}
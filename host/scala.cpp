@@ -0,0 +1,228 @@
+/* -*- mode: c++; tab-width: 8 -*- */
+/*
+  Copyright (C) 2018 by Roger E Critchlow Jr, Charlestown, MA, USA.
+
+  This program is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation; either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program; if not, write to the Free Software
+  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307 USA
+*/
+/*
+** Convert a Scala scale, and keyboard mapping, to the tuning SysEx.
+**
+**   g++ -O2 -I host -I teensyduino/Pennywhistle host/scala.cpp -o scala
+**   ./scala scale.scl [mapping.kbm] [-o tuning.syx]
+**
+** A .scl file has a description, the number of pitches, and the
+** pitches, cents if they have a decimal point, else ratios such as
+** 5/4 or 2, the last being the period, usually the octave.  A .kbm
+** file has the map size, the first and last keys tuned, the middle
+** key, where degree 0 sits, the reference key and its frequency, the
+** degree of the formal octave, and the degree for each key of the
+** map, or x to leave a key alone.  Lines starting with ! are comments.
+** Without a .kbm the scale repeats from key 60, at 261.6256Hz.
+**
+** The keys are written as Tuning.h's SysEx, F0 7D 03 and 32 keys of
+** key, semitone, and 14 bit fraction from A 440, then F7, to the -o
+** file, which can be sent with amidi -s, and are read back through
+** Tuning::retune() to print the table each key plays, its nearest
+** note, cents, and frequency, with the error of the encoding.
+*/
+#include "AudioStream.h"
+#include "Config.h"
+#include "Tuning.h"
+
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+#include <string>
+#include <vector>
+
+uint32_t host_micros;
+
+static const int KEYS_PER_MESSAGE = 32;	/* 132 bytes, under Teensy's usb sysex buffer */
+
+/* the non-comment lines of a file */
+static bool read_lines(const char *file, std::vector<std::string> &lines) {
+  FILE *fp = fopen(file, "r");
+  if (fp == NULL) { perror(file); return false; }
+  char line[256];
+  while (fgets(line, sizeof(line), fp) != NULL)
+    if (line[0] != '!') lines.push_back(line);
+  fclose(fp);
+  return true;
+}
+
+/* a .scl pitch in cents */
+static bool parse_pitch(const char *text, double &cents) {
+  while (*text == ' ' || *text == '\t') text += 1;
+  const char *end = text + strcspn(text, " \t\r\n");
+  if (memchr(text, '.', end - text) != NULL) return sscanf(text, "%lf", &cents) == 1;
+  long num, den = 1;
+  if (sscanf(text, "%ld/%ld", &num, &den) < 1 || num <= 0 || den <= 0) return false;
+  cents = 1200 * log2((double)num / den);
+  return true;
+}
+
+struct Scale {
+  std::vector<double> pitches;	/* cents of degrees 1 to n, degree 0 is 0 */
+  /* the cents of any degree, beyond the period it repeats */
+  double cents(int degree) const {
+    int n = pitches.size();
+    int periods = degree >= 0 ? degree / n : -((n - 1 - degree) / n);
+    degree -= periods * n;
+    return periods * pitches[n-1] + (degree ? pitches[degree-1] : 0);
+  }
+};
+
+struct Mapping {
+  int size = 0, first = 0, last = 127, middle = 60, reference = 60, octave = 0;
+  double frequency = 261.625565;
+  std::vector<int> degrees;	/* -1 for unmapped */
+};
+
+static bool read_scale(const char *file, Scale &scale) {
+  std::vector<std::string> lines;
+  if ( ! read_lines(file, lines)) return false;
+  int n;
+  if (lines.size() < 2 || sscanf(lines[1].c_str(), "%d", &n) != 1 || n < 1 || (int)lines.size() < n + 2) {
+    fprintf(stderr, "%s: no pitch count, or too few pitches\n", file);
+    return false;
+  }
+  for (int i = 0; i < n; i += 1) {
+    double cents;
+    if ( ! parse_pitch(lines[i+2].c_str(), cents)) {
+      fprintf(stderr, "%s: bad pitch %s", file, lines[i+2].c_str());
+      return false;
+    }
+    scale.pitches.push_back(cents);
+  }
+  return true;
+}
+
+static bool read_mapping(const char *file, Mapping &map) {
+  std::vector<std::string> lines;
+  if ( ! read_lines(file, lines)) return false;
+  if (lines.size() < 7 ||
+      sscanf(lines[0].c_str(), "%d", &map.size) != 1 || sscanf(lines[1].c_str(), "%d", &map.first) != 1 ||
+      sscanf(lines[2].c_str(), "%d", &map.last) != 1 || sscanf(lines[3].c_str(), "%d", &map.middle) != 1 ||
+      sscanf(lines[4].c_str(), "%d", &map.reference) != 1 || sscanf(lines[5].c_str(), "%lf", &map.frequency) != 1 ||
+      sscanf(lines[6].c_str(), "%d", &map.octave) != 1 || map.size < 0 || (int)lines.size() < 7 + map.size) {
+    fprintf(stderr, "%s: bad keyboard mapping header\n", file);
+    return false;
+  }
+  for (int i = 0; i < map.size; i += 1) {
+    int degree;
+    if (sscanf(lines[7+i].c_str(), "%d", &degree) == 1) map.degrees.push_back(degree);
+    else map.degrees.push_back(-1);	/* x */
+  }
+  return true;
+}
+
+/* the cents of a key above the middle key, false if it isn't mapped */
+static bool key_cents(const Scale &scale, const Mapping &map, int key, double &cents) {
+  if (key < map.first || key > map.last) return false;
+  int d = key - map.middle;
+  if (map.size == 0) {
+    cents = scale.cents(d);
+    return true;
+  }
+  int periods = d >= 0 ? d / map.size : -((map.size - 1 - d) / map.size);
+  int degree = map.degrees[d - periods * map.size];
+  if (degree < 0) return false;
+  int octave = map.octave ? map.octave : scale.pitches.size();
+  cents = periods * scale.cents(octave) + scale.cents(degree);
+  return true;
+}
+
+int main(int argc, char *argv[]) {
+  const char *output = NULL;
+  int c;
+  while ((c = getopt(argc, argv, "o:")) != -1) {
+    switch (c) {
+    case 'o': output = optarg; break;
+    default:
+      fprintf(stderr, "usage: %s scale.scl [mapping.kbm] [-o tuning.syx]\n", argv[0]);
+      return 1;
+    }
+  }
+  if (optind >= argc) {
+    fprintf(stderr, "usage: %s scale.scl [mapping.kbm] [-o tuning.syx]\n", argv[0]);
+    return 1;
+  }
+  Scale scale;
+  Mapping map;
+  if ( ! read_scale(argv[optind], scale)) return 1;
+  if (optind + 1 < argc && ! read_mapping(argv[optind+1], map)) return 1;
+  double reference;
+  if ( ! key_cents(scale, map, map.reference, reference)) {
+    fprintf(stderr, "reference key %d isn't mapped\n", map.reference);
+    return 1;
+  }
+
+  // each key as a pitch in semitones from A 440, 7F 7F 7F if unmapped
+  std::vector<uint8_t> keys;
+  double pitches[128];
+  for (int key = 0; key < 128; key += 1) {
+    double cents;
+    uint8_t entry[4] = { (uint8_t)key, 0x7F, 0x7F, 0x7F };
+    pitches[key] = -1;
+    if (key_cents(scale, map, key, cents)) {
+      double hz = map.frequency * pow(2, (cents - reference) / 1200);
+      double pitch = Midi::A_440 + 12 * log2(hz / 440);
+      if (pitch >= 0 && pitch < 127.99) {
+	int semitone = (int)pitch, fraction = lrint((pitch - semitone) * 16384);
+	if (fraction == 16384) { semitone += 1; fraction = 0; }
+	entry[1] = semitone;
+	entry[2] = fraction >> 7;
+	entry[3] = fraction & 0x7F;
+	pitches[key] = pitch;
+      }
+    }
+    keys.insert(keys.end(), entry, entry + 4);
+  }
+
+  // the SysEx messages, and back through the device's table
+  std::vector<uint8_t> syx;
+  Tuning::equal();
+  for (int key = 0; key < 128; key += KEYS_PER_MESSAGE) {
+    const uint8_t head[] = { 0xF0, SYSEX_ID, SYSEX_TUNING };
+    syx.insert(syx.end(), head, head + 3);
+    syx.insert(syx.end(), &keys[key*4], &keys[(key+KEYS_PER_MESSAGE)*4]);
+    syx.push_back(0xF7);
+    if ( ! Tuning::retune(&keys[key*4], KEYS_PER_MESSAGE*4)) {
+      fprintf(stderr, "retune refused keys %d to %d\n", key, key + KEYS_PER_MESSAGE - 1);
+      return 1;
+    }
+  }
+  printf("%s: %zu pitches, period %.3f cents, reference key %d at %.4fHz\n",
+	 argv[optind], scale.pitches.size(), scale.pitches.back(), map.reference, map.frequency);
+  double worst = 0;
+  for (int key = 0; key < 128; key += 1) {
+    if (pitches[key] < 0) continue;
+    double error = 100 * (Tuning::note(key) + Tuning::cents(key) / 100.0 - pitches[key]);
+    if (fabs(error) > worst) worst = fabs(error);
+    if (key >= map.middle - 12 && key <= map.middle + 24)
+      printf("key %3d: note %3d %+7.2f cents %9.3fHz\n", key, Tuning::note(key), Tuning::cents(key), Tuning::hertz(key));
+  }
+  printf("worst encoding error %.4f cents, %d keys retuned\n", worst, Tuning::_retuned);
+  if (output != NULL) {
+    FILE *fp = fopen(output, "wb");
+    if (fp == NULL || fwrite(syx.data(), 1, syx.size(), fp) != syx.size()) {
+      perror(output);
+      return 1;
+    }
+    fclose(fp);
+    printf("%s: %zu bytes in %d messages\n", output, syx.size(), 128 / KEYS_PER_MESSAGE);
+  }
+  return 0;
+}
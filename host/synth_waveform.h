@@ -0,0 +1,64 @@
+/* -*- mode: c++; tab-width: 8 -*- */
+/*
+  Copyright (C) 2018 by Roger E Critchlow Jr, Charlestown, MA, USA.
+
+  This program is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation; either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program; if not, write to the Free Software
+  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307 USA
+*/
+/*
+** Host stand in for the Teensy Audio library's AudioSynthWaveform,
+** the sawtooth only, computed as the library computes it: a 32 bit
+** phase accumulator whose top half, scaled by the amplitude, is the
+** sample.  At zero amplitude the phase runs on and nothing is sent.
+*/
+#ifndef synth_waveform_h_
+#define synth_waveform_h_
+
+#include "AudioStream.h"
+
+#define WAVEFORM_SINE		0
+#define WAVEFORM_SAWTOOTH	1
+
+class AudioSynthWaveform : public AudioStream
+{
+ public:
+  AudioSynthWaveform() : AudioStream(0, NULL), _phase(0), _increment(0), _magnitude(0), _type(WAVEFORM_SAWTOOTH) {}
+  void frequency(float freq) {
+    if (freq < 0.0f) freq = 0.0f;
+    else if (freq > AUDIO_SAMPLE_RATE_EXACT / 2) freq = AUDIO_SAMPLE_RATE_EXACT / 2;
+    _increment = freq * (4294967296.0f / AUDIO_SAMPLE_RATE_EXACT);
+  }
+  void amplitude(float n) { _magnitude = constrain(n, 0.0f, 1.0f) * 65536.0f; }
+  void begin(float amp, float freq, short type) { _type = type; amplitude(amp); frequency(freq); }
+
+  virtual void update(void) {
+    if (_magnitude == 0 || _type != WAVEFORM_SAWTOOTH) {
+      _phase += _increment * AUDIO_BLOCK_SAMPLES;
+      return;
+    }
+    audio_block_t *block = allocate();
+    if (block == NULL) return;
+    for (int n = 0; n < AUDIO_BLOCK_SAMPLES; n += 1, _phase += _increment)
+      block->data[n] = ((int64_t)_magnitude * (int16_t)(_phase >> 16)) >> 16;
+    transmit(block);
+    release(block);
+  }
+
+ private:
+  uint32_t _phase, _increment;
+  int32_t _magnitude;
+  short _type;
+};
+
+#endif
@@ -0,0 +1,78 @@
+/* -*- mode: c++; tab-width: 8 -*- */
+/*
+  Copyright (C) 2018 by Roger E Critchlow Jr, Charlestown, MA, USA.
+
+  This program is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation; either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program; if not, write to the Free Software
+  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307 USA
+*/
+/*
+** Check the fine pitch of Midi::hertz() and Midi::phase_increment()
+** against double precision pow().
+**
+**   g++ -O2 -I host -I teensyduino/Pennywhistle host/tuning.cpp -o tuning
+**   ./tuning [A 440 in Hz]
+**
+** Every note, bent from -1200 to +1200 cents in steps of 0.37 cents,
+** reports the worst and rms error in cents, for the phase increment
+** only below nyquist, and the time per call on this host, which only
+** compares the two, the M4F has no double precision unit.
+*/
+#include "AudioStream.h"
+#include "Config.h"
+#include "Midi.h"
+
+#include <stdio.h>
+#include <time.h>
+
+uint32_t host_micros;
+
+static double seconds() {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+int main(int argc, char *argv[]) {
+  if (argc > 1) Midi::tuning(atof(argv[1]));
+  double a4 = Midi::tuning();
+  double hz_max = 0, hz_sum = 0, inc_max = 0, inc_sum = 0;
+  int n_hz = 0, n_inc = 0;
+  for (int note = 0; note < 128; note += 1)
+    for (float cents = -1200; cents <= 1200; cents += 0.37f) {
+      double hz = a4 * pow(2.0, (note - Midi::A_440 + cents / 100.0) / 12.0);
+      double e = 1200 * log2(Midi::hertz(note, cents) / hz);
+      hz_sum += e * e;
+      if (fabs(e) > hz_max) hz_max = fabs(e);
+      n_hz += 1;
+      double inc = hz * 4294967296.0 / AUDIO_SAMPLE_RATE_EXACT;
+      if (inc < 1000 || inc >= 2147483648.0) continue;	/* too coarse, or past nyquist */
+      e = 1200 * log2(Midi::phase_increment(note, cents) / inc);
+      inc_sum += e * e;
+      if (fabs(e) > inc_max) inc_max = fabs(e);
+      n_inc += 1;
+    }
+  printf("A %.1fHz\n", a4);
+  printf("hertz           worst %6.4f cents, rms %6.4f cents\n", hz_max, sqrt(hz_sum / n_hz));
+  printf("phase_increment worst %6.4f cents, rms %6.4f cents\n", inc_max, sqrt(inc_sum / n_inc));
+
+  const int N = 10000000;
+  volatile float sink = 0;
+  double t0 = seconds();
+  for (int i = 0; i < N; i += 1) sink = sink + Midi::hertz(i & 127, (i & 255) * 0.1f);
+  double t1 = seconds();
+  for (int i = 0; i < N; i += 1) sink = sink + a4 * pow(2, ((i & 127) - Midi::A_440 + (i & 255) * 0.001) / 12.0);
+  double t2 = seconds();
+  printf("hertz %.1fns, pow %.1fns per call\n", (t1 - t0) * 1e9 / N, (t2 - t1) * 1e9 / N);
+  return 0;
+}
@@ -0,0 +1,130 @@
+/* -*- mode: c++; tab-width: 8 -*- */
+/*
+  Copyright (C) 2018 by Roger E Critchlow Jr, Charlestown, MA, USA.
+
+  This program is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation; either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program; if not, write to the Free Software
+  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307 USA
+*/
+/*
+** Check the crossfade of AudioVoiceSwitch as the sketch drives it.
+**
+**   g++ -O2 -I host -I teensyduino/Pennywhistle host/voiceswitch.cpp -o voiceswitch
+**   ./voiceswitch [-f fade blocks] [-m memory blocks]
+**
+** Two voices hold full scale, one positive and one negative, into
+** the switch.  Every 50 blocks the other voice is selected, and the
+** old one is silenced only once fading() is false, as synth_poll()
+** does.  It reports the largest step between successive output
+** samples against the step of the ramp, the blocks missing from the
+** output, and the blocks the old voice sounded after its switch.
+** With -m 2 the pool is too small for a fade block, so the new
+** voice should pass straight through without a missing block.
+*/
+#define AUDIO_STREAM_STATICS 1
+#include "Audio.h"
+#include "AudioVoiceSwitch.h"
+
+#include <stdio.h>
+#include <unistd.h>
+
+/* a voice holding a level, transmitting nothing when silenced */
+class AudioSynthHostLevel : public AudioStream
+{
+ public:
+  AudioSynthHostLevel() : AudioStream(0, NULL), level(0), on(false) {}
+  virtual void update(void) {
+    if ( ! on) return;
+    audio_block_t *block = allocate();
+    if (block == NULL) return;
+    for (int n = 0; n < AUDIO_BLOCK_SAMPLES; n += 1) block->data[n] = level;
+    transmit(block);
+    release(block);
+  }
+  int16_t level;
+  bool on;
+};
+
+class AudioCheckHost : public AudioStream
+{
+ public:
+  AudioCheckHost() : AudioStream(1, inputQueueArray), y1(0), maxd(0), blocks(0), missing(0) {}
+  virtual void update(void) {
+    audio_block_t *block = receiveReadOnly();
+    if (block == NULL) { missing += 1; return; }
+    for (int n = 0; n < AUDIO_BLOCK_SAMPLES; n += 1) {
+      int32_t y = block->data[n];
+      if (blocks != 0 && abs(y - y1) > maxd) maxd = abs(y - y1);
+      y1 = y;
+    }
+    blocks += 1;
+    release(block);
+  }
+  int32_t y1, maxd;
+  long blocks, missing;
+ private:
+  audio_block_t *inputQueueArray[1];
+};
+
+AudioSynthHostLevel      voice0;
+AudioSynthHostLevel      voice1;
+AudioVoiceSwitch         switch1;
+AudioCheckHost           check1;
+AudioConnection          patchCord1(voice0, 0, switch1, 0);
+AudioConnection          patchCord2(voice1, 0, switch1, 1);
+AudioConnection          patchCord3(switch1, 0, check1, 0);
+
+int main(int argc, char *argv[]) {
+  int fade = 2, memory = 8;
+  int c;
+  while ((c = getopt(argc, argv, "f:m:")) != -1) {
+    switch (c) {
+    case 'f': fade = atoi(optarg); break;
+    case 'm': memory = atoi(optarg); break;
+    default:
+      fprintf(stderr, "usage: %s [-f fade blocks] [-m memory blocks]\n", argv[0]);
+      return 1;
+    }
+  }
+  AudioMemory(memory);
+  switch1.fadeBlocks(fade);
+  AudioSynthHostLevel *voices[2] = { &voice0, &voice1 };
+  voice0.level = 32767;
+  voice1.level = -32767;
+  voice0.on = true;
+  const long nblocks = 1000;
+  int fading = 0;			/* mask of old voices, as synth_fading */
+  long switches = 0, sounding = 0, sounding_max = 0;
+  for (long b = 0; b < nblocks; b += 1) {
+    if (b % 50 == 25) {
+      uint8_t old = switch1.selected(), voice = old ^ 1;
+      fading = (fading | (1<<old)) & ~(1<<voice);
+      switch1.select(voice);
+      voices[voice]->on = true;
+      switches += 1;
+      sounding = 0;
+    }
+    if (fading != 0 && ! switch1.fading()) {
+      for (int v = 0; v < 2; v += 1)
+	if (fading & (1<<v)) voices[v]->on = false;
+      fading = 0;
+      if (sounding > sounding_max) sounding_max = sounding;
+    }
+    if (fading != 0) sounding += 1;
+    AudioStream::update_all();
+  }
+  printf("%ld blocks, %ld switches, fade %d blocks, memory %d blocks\n", nblocks, switches, fade, memory);
+  printf("largest step %d, ramp step %d\n", check1.maxd, 2 * 32767 / (fade * AUDIO_BLOCK_SAMPLES) + 1);
+  printf("missing blocks %ld, old voice sounded %ld blocks after a switch\n", check1.missing, sounding_max);
+  return 0;
+}
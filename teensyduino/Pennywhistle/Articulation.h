@@ -0,0 +1,128 @@
+/* -*- mode: c++; tab-width: 8 -*- */
+/*
+  Copyright (C) 2018 by Roger E Critchlow Jr, Charlestown, MA, USA.
+
+  This program is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation; either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program; if not, write to the Free Software
+  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307 USA
+*/
+/*
+** Tonguing, found in the fused breath level, so a repeated note can
+** be played without a change of fingering.
+**
+** The held level follows the breath up at once and down with a
+** 150ms time constant, so a diminuendo drags it along.  A tongue
+** stop falls faster than slope() per second; from the first sample
+** that falls that fast, once the breath is more than depth() of the
+** held level below it, update() returns STOP.  Then once the breath
+** is back up recover() of the way from the bottom of the dip to the
+** held level, it returns START.  A breath which simply ends is a STOP
+** without a START, until the next breath.
+**
+** At the mic's 2.9ms updates a sharp tongue stop is found in two or
+** three samples.  Samples stamped no later than the last are
+** ignored.  report() gives the count of tongued stops and of starts,
+** the time from the start of the fall to the STOP, the added latency,
+** on average and at most, and the shortest dip.
+*/
+#ifndef Articulation_h
+#define Articulation_h
+
+namespace Articulation {
+  enum { NONE, STOP, START };
+  static const float GATE = 0.02f;	/* below this there's no breath to tongue */
+  static const float FOLLOW_US = 150000.0f;	/* how fast the held level falls with the breath */
+
+  static float _depth = 0.3f, _slope = 3.0f, _recover = 0.5f;
+  static float _held, _last, _bottom;
+  static uint32_t _lastStamp, _fallStamp, _stopStamp;
+  static uint8_t _falling, _stopped = 1, _tongued;
+
+  // added latency, microseconds
+  static uint32_t _stops, _starts;
+  static uint64_t _latencySum;
+  static uint32_t _latencyMax, _dipMin = 0xFFFFFFFF;
+
+  /* the fraction of the held level a stop dips */
+  void depth(float d) { _depth = constrain(d, 0.05f, 0.95f); }
+  /* the fall rate of a stop, full breath per second */
+  void slope(float s) { _slope = constrain(s, 0.1f, 100.0f); }
+  /* the fraction of the dip the breath must recover to start again */
+  void recover(float r) { _recover = constrain(r, 0.05f, 1.0f); }
+  /* true between a STOP and a START */
+  bool stopped() { return _stopped; }
+
+  /* the breath level, 0 to 1, taken at stamp micros, returns NONE, STOP, or START */
+  uint8_t update(float level, uint32_t stamp) {
+    int32_t dt = stamp - _lastStamp;
+    if (dt <= 0) return NONE;		/* out of order, or a repeat */
+    float rate = (_last - level) * 1e6f / dt;
+    uint32_t before = _lastStamp;
+    _last = level;
+    _lastStamp = stamp;
+    if (_stopped) {
+      if (level < _bottom) _bottom = level;
+      if (level > GATE && level >= _bottom + _recover * (_held - _bottom)) {
+	_stopped = 0;
+	_held = level;
+	_falling = 0;
+	_starts += 1;
+	if (_tongued && stamp - _stopStamp < _dipMin) _dipMin = stamp - _stopStamp;
+	return START;
+      }
+      return NONE;
+    }
+    if (level > _held) _held = level;
+    else _held += min(dt / FOLLOW_US, 1.0f) * (level - _held);
+    if (rate >= _slope) {
+      if ( ! _falling) _fallStamp = before;
+      _falling = 1;
+    } else if (rate < _slope / 4) {
+      _falling = 0;
+    }
+    if ((_falling && level < (1 - _depth) * _held) || level < GATE) {
+      if (_falling) {
+	uint32_t latency = stamp - _fallStamp;
+	_latencySum += latency;
+	if (latency > _latencyMax) _latencyMax = latency;
+	_stops += 1;
+      } else {
+	_held = level;		/* the breath ended, any next breath starts */
+      }
+      _tongued = _falling;
+      _stopped = 1;
+      _bottom = level;
+      _stopStamp = stamp;
+      return STOP;
+    }
+    return NONE;
+  }
+
+  int begin() {
+    depth(ARTICULATION_DEPTH);
+    slope(ARTICULATION_SLOPE);
+    recover(ARTICULATION_RECOVER);
+    return 1;
+  }
+  void report() {
+    Serial.printf("articulation depth %4.2f slope %4.1f/s recover %4.2f, %s\n", _depth, _slope, _recover,
+		  _stopped ? "stopped" : "sounding");
+    Serial.printf("stops %lu, starts %lu, latency avg %luus max %luus, shortest dip %luus\n",
+		  (unsigned long)_stops, (unsigned long)_starts, _stops ? (unsigned long)(_latencySum / _stops) : 0UL,
+		  (unsigned long)_latencyMax, _dipMin != 0xFFFFFFFF ? (unsigned long)_dipMin : 0UL);
+    _stops = _starts = 0;
+    _latencySum = 0; _latencyMax = 0; _dipMin = 0xFFFFFFFF;
+  }
+};
+
+#endif // Articulation_h
@@ -0,0 +1,77 @@
+/* -*- mode: c++; tab-width: 8 -*- */
+/*
+  Copyright (C) 2018 by Roger E Critchlow Jr, Charlestown, MA, USA.
+
+  This program is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation; either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program; if not, write to the Free Software
+  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307 USA
+*/
+/*
+** The library's AudioAmplifier with its gain an AudioParam, so
+** gain() can be called from loop() as often as it likes without
+** zipper noise, the gain ramps across the block after each change,
+** in even dB steps.  A steady gain of 1 passes the block through,
+** a steady 0 passes nothing, and anything else scales in place.
+*/
+#ifndef AudioAmplifierRamp_h
+#define AudioAmplifierRamp_h
+
+#include <AudioStream.h>
+#include "AudioParam.h"
+
+class AudioAmplifierRamp : public AudioStream
+{
+ public:
+  AudioAmplifierRamp() : AudioStream(1, inputQueueArray), _gain(1.0f, AudioParam::EXPONENTIAL) {}
+  /* gain, 0 to 32767 */
+  void gain(float level) { _gain.set(constrain(level, 0.0f, 32767.0f)); }
+
+  virtual void update(void) {
+    if ( ! _gain.start()) {
+      int32_t g = _gain.value();
+      if (g == AudioParam::ONE) {
+	audio_block_t *block = receiveReadOnly();
+	if (block == NULL) return;
+	transmit(block);
+	release(block);
+	return;
+      }
+      if (g == 0) {
+	audio_block_t *block = receiveReadOnly();
+	if (block != NULL) release(block);
+	return;
+      }
+      audio_block_t *block = receiveWritable();
+      if (block == NULL) return;
+      for (int n = 0; n < AUDIO_BLOCK_SAMPLES; n += 1)
+	block->data[n] = sat16(((int64_t)block->data[n] * g) >> 16);
+      transmit(block);
+      release(block);
+      return;
+    }
+    audio_block_t *block = receiveWritable();
+    if (block == NULL) return;
+    for (int n = 0; n < AUDIO_BLOCK_SAMPLES; n += 1)
+      block->data[n] = sat16(((int64_t)block->data[n] * _gain.next()) >> 16);
+    transmit(block);
+    release(block);
+  }
+
+ private:
+  static inline int16_t sat16(int32_t x) { return x > 32767 ? 32767 : x < -32768 ? -32768 : x; }
+
+  audio_block_t *inputQueueArray[1];
+  AudioParam _gain;
+};
+
+#endif // AudioAmplifierRamp_h
@@ -0,0 +1,121 @@
+/* -*- mode: c++; tab-width: 8 -*- */
+/*
+  Copyright (C) 2018 by Roger E Critchlow Jr, Charlestown, MA, USA.
+
+  This program is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation; either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program; if not, write to the Free Software
+  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307 USA
+*/
+/*
+** Breath envelope from the microphone, as a Teensy Audio analysis
+** object with one input and no outputs.
+**
+** Each block is dc blocked and its rms taken, which for a player
+** blowing across the mic is mostly breath noise.  The rms, scaled
+** by fullScale() to 0..1, drives an attack/release envelope at block
+** rate, 2.9ms, and a noise gate with hysteresis, open above gate()
+** and closed again below half of it, so room noise reads as zero.
+**
+** The loop polls available() and read(), as for the library's
+** analyzers, and stamp() gives the micros() of the last block, so
+** a breath onset is seen within one block of reaching the mic,
+** rather than at the next barometer conversion.  onsets() counts
+** the times the gate has opened.
+*/
+#ifndef AudioAnalyzeBreath_h
+#define AudioAnalyzeBreath_h
+
+#include <AudioStream.h>
+#include <math.h>
+
+class AudioAnalyzeBreath : public AudioStream
+{
+ public:
+  AudioAnalyzeBreath() : AudioStream(1, inputQueueArray) {
+    _dcx = _dcy = 0;
+    _rms = _env = 0;
+    _open = 0;
+    _available = 0;
+    _stamp = 0;
+    _onsets = 0;
+    attack(3);
+    release(60);
+    gate(0.02f);
+    fullScale(0.25f);
+  }
+  /* envelope rise and fall time constants in milliseconds */
+  void attack(float ms) { _attack = coefficient(ms); }
+  void release(float ms) { _release = coefficient(ms); }
+  /* gate opening level, 0 to 1 of full scale */
+  void gate(float level) { _gate = constrain(level, 0.0f, 1.0f); }
+  /* the rms, 0 to 1 of digital full scale, which counts as full breath */
+  void fullScale(float rms) { _fullScale = constrain(rms, 0.001f, 1.0f); }
+
+  bool available() { return _available; }
+  /* the gated envelope, 0 to 1 */
+  float read() {
+    _available = 0;
+    return level();
+  }
+  /* the same, without taking it */
+  float level() { return _open ? _env : 0.0f; }
+  /* the block rms before scaling, 0 to 1, for setting fullScale() and gate() */
+  float rms() { return _rms; }
+  uint32_t stamp() { return _stamp; }
+  uint32_t onsets() { return _onsets; }
+
+  virtual void update(void) {
+    audio_block_t *block = receiveReadOnly();
+    if (block == NULL) return;
+    int64_t sum = 0;
+    int32_t x1 = _dcx, y1 = _dcy;
+    for (int n = 0; n < AUDIO_BLOCK_SAMPLES; n += 1) {
+      int32_t x = block->data[n];
+      y1 = x - x1 + ((y1 * DC_POLE) >> 15);
+      x1 = x;
+      sum += (int64_t)y1 * y1;
+    }
+    _dcx = x1; _dcy = y1;
+    AudioStream::release(block);
+    _rms = sqrtf((float)sum / AUDIO_BLOCK_SAMPLES) / 32768.0f;
+    float level = _rms / _fullScale;
+    if (level > 1.0f) level = 1.0f;
+    _env += (level - _env) * (level > _env ? _attack : _release);
+    if ( ! _open && _env > _gate) {
+      _open = 1;
+      _onsets += 1;
+    } else if (_open && _env < 0.5f * _gate) {
+      _open = 0;
+    }
+    _stamp = micros();
+    _available = 1;
+  }
+
+ private:
+  static const int32_t DC_POLE = 32440;	/* 0.99, dc blocker pole */
+
+  /* one pole coefficient for a time constant in ms, at block rate */
+  static float coefficient(float ms) {
+    float blockms = 1000.0f * AUDIO_BLOCK_SAMPLES / AUDIO_SAMPLE_RATE_EXACT;
+    return ms <= blockms ? 1.0f : 1.0f - expf(-blockms / ms);
+  }
+
+  audio_block_t *inputQueueArray[1];
+  int32_t _dcx, _dcy;
+  float _attack, _release, _gate, _fullScale;
+  volatile float _rms, _env;
+  volatile uint8_t _open, _available;
+  volatile uint32_t _stamp, _onsets;
+};
+
+#endif // AudioAnalyzeBreath_h
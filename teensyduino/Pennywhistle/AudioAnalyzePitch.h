@@ -0,0 +1,205 @@
+/* -*- mode: c++; tab-width: 8 -*- */
+/*
+  Copyright (C) 2018 by Roger E Critchlow Jr, Charlestown, MA, USA.
+
+  This program is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation; either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program; if not, write to the Free Software
+  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307 USA
+*/
+/*
+** Pitch of the microphone input, by YIN, as a Teensy Audio analysis
+** object with one input and no outputs.  The interface follows the
+** library's AudioAnalyzeNoteFrequency: available(), read() in Hz,
+** and probability().
+**
+** The input is decimated by 2 with arm_fir_decimate_q15, to 22kHz,
+** and collected in frames of WINDOW+LAGS samples, four audio blocks.
+** While the next frame fills, the YIN difference function of the
+** last one is computed a quarter of the lags per block,
+**   d(tau) = E(x[0..W)) + E(x[tau..tau+W)) - 2 x[0..W).x[tau..tau+W)
+** with arm_dot_prod_q15 for the cross term and running sums for the
+** energies, all in 64 bit fixed point, so every block costs about
+** the same.  On the fourth block d is normalized by its cumulative
+** mean, in float, and the first dip under threshold() is found.
+**
+** A lag of a few decimated samples is too coarse to interpolate, so
+** the dip is refined on the undecimated frame: the difference,
+** normalized by the two windows' energies, at the five full rate
+** lags about it, and a parabola through the least and its
+** neighbours.  Above about 2.7kHz a period may fall between the
+** decimated lags without a dip under threshold, so when the dip
+** found is short the lag of half its period is tried the same way
+** first, and taken if it dips under threshold.  This adds some
+** 10 dot products of 256 samples to the fourth block.
+**
+** Range 172Hz to 5.5kHz, within a cent or two of a sine, a new
+** estimate every 11.6ms, about 23ms after the sound.  Frames quieter
+** than minimumLevel() are skipped.
+*/
+#ifndef AudioAnalyzePitch_h
+#define AudioAnalyzePitch_h
+
+#include <AudioStream.h>
+#include <arm_math.h>
+
+class AudioAnalyzePitch : public AudioStream
+{
+ public:
+  static const int DECIMATE = 2;
+  static const int WINDOW = 128;	/* decimated samples compared */
+  static const int LAGS = 128;		/* decimated lags tried */
+  static const int FRAME = WINDOW+LAGS;
+  static const int STEPS = FRAME * DECIMATE / AUDIO_BLOCK_SAMPLES;
+  static const int MIN_LAG = 4;
+
+  AudioAnalyzePitch() : AudioStream(1, inputQueueArray) {
+    arm_fir_decimate_init_q15(&_decimator, TAPS, DECIMATE, _coeffs, _state, AUDIO_BLOCK_SAMPLES);
+    _fill = _frames[0];
+    _work = _frames[1];
+    _rawFill = _raw[0];
+    _rawWork = _raw[1];
+    _nfill = 0;
+    _step = STEPS;
+    _available = 0;
+    _frequency = _probability = 0;
+    threshold(0.15f);
+    minimumLevel(0.01f);
+  }
+  /* the YIN threshold on the normalized difference, 0.1 to 0.2 is usual */
+  void threshold(float t) { _threshold = constrain(t, 0.01f, 0.99f); }
+  /* the rms, 0 to 1 of full scale, below which no pitch is reported */
+  void minimumLevel(float rms) {
+    float e = rms * 32768.0f;
+    _minPower = (int64_t)(e * e * WINDOW);
+  }
+
+  bool available() { return _available; }
+  /* the frequency in Hz */
+  float read() {
+    _available = 0;
+    return _frequency;
+  }
+  /* 1 minus the normalized difference at the pitch, 0 to 1 */
+  float probability() { return _probability; }
+
+  virtual void update(void) {
+    audio_block_t *block = receiveReadOnly();
+    if (block == NULL) return;
+    arm_fir_decimate_q15(&_decimator, block->data, _fill + _nfill, AUDIO_BLOCK_SAMPLES);
+    memcpy(_rawFill + _nfill * DECIMATE, block->data, sizeof(block->data));
+    release(block);
+    _nfill += AUDIO_BLOCK_SAMPLES / DECIMATE;
+    if (_step < STEPS) {
+      difference(_step * LAGS / STEPS, (_step + 1) * LAGS / STEPS);
+      _step += 1;
+      if (_step == STEPS) pick();
+    }
+    if (_nfill == FRAME) {
+      q15_t *t = _work; _work = _fill; _fill = t;
+      t = _rawWork; _rawWork = _rawFill; _rawFill = t;
+      _nfill = 0;
+      _step = 0;
+    }
+  }
+
+ private:
+  static const int TAPS = 15;
+  static q15_t _coeffs[TAPS];
+
+  /* d(tau) for lags from up to to */
+  void difference(int from, int to) {
+    if (from == 0) {
+      arm_power_q15(_work, WINDOW, &_energy0);
+      _energy = _energy0;
+    }
+    for (int tau = from; tau < to; tau += 1) {
+      q63_t cross;
+      arm_dot_prod_q15(_work, _work + tau, WINDOW, &cross);
+      _d[tau] = _energy0 + _energy - 2 * cross;
+      // slide the lagged energy along one sample
+      int32_t out = _work[tau], in = _work[tau + WINDOW];
+      _energy += in * in - out * out;
+    }
+  }
+
+  /* the first dip of the cumulative mean normalized difference under threshold */
+  void pick() {
+    if (_energy0 < _minPower) return;
+    float cum = 0, dn[LAGS];
+    dn[0] = 1.0f;
+    for (int tau = 1; tau < LAGS; tau += 1) {
+      cum += _d[tau];
+      dn[tau] = cum > 0 ? _d[tau] * tau / cum : 1.0f;
+    }
+    int tau = MIN_LAG;
+    while (tau < LAGS-1 && dn[tau] >= _threshold) tau += 1;
+    if (tau >= LAGS-1) return;
+    while (tau < LAGS-2 && dn[tau+1] < dn[tau]) tau += 1;
+    float probability = 1.0f - dn[tau];
+    float period = 0;
+    if (tau <= 4*MIN_LAG && tau >= 2*MIN_LAG) {
+      // an octave up, where the decimated lags may have missed it
+      period = refine(tau);
+      if (_dip < _threshold) probability = 1.0f - _dip;
+      else period = 0;
+    }
+    if (period == 0) period = refine(DECIMATE * tau);
+    _frequency = AUDIO_SAMPLE_RATE_EXACT / period;
+    _probability = probability;
+    _available = 1;
+  }
+
+  /* the difference at full rate lag, over the energies of the windows, 0 for a repeat, about 1 for noise */
+  float rawDifference(int lag) {
+    q63_t e0, e1, cross;
+    arm_power_q15(_rawWork, DECIMATE*WINDOW, &e0);
+    arm_power_q15(_rawWork + lag, DECIMATE*WINDOW, &e1);
+    arm_dot_prod_q15(_rawWork, _rawWork + lag, DECIMATE*WINDOW, &cross);
+    return e0 + e1 > 0 ? (float)(e0 + e1 - 2*cross) / (float)(e0 + e1) : 1.0f;
+  }
+
+  /* the full rate period near lag, leaves its difference in _dip */
+  float refine(int lag) {
+    float r[5];
+    for (int i = 0; i < 5; i += 1) r[i] = rawDifference(lag - 2 + i);
+    int m = 1;
+    for (int i = 2; i < 4; i += 1) if (r[i] < r[m]) m = i;
+    float a = r[m-1], b = r[m], c = r[m+1];
+    float den = a - 2*b + c;
+    float shift = den > 0 ? 0.5f * (a - c) / den : 0.0f;
+    _dip = b;
+    return lag - 2 + m + shift;
+  }
+
+  audio_block_t *inputQueueArray[1];
+  arm_fir_decimate_instance_q15 _decimator;
+  q15_t _state[TAPS + AUDIO_BLOCK_SAMPLES - 1];
+  q15_t _frames[2][FRAME];
+  q15_t *_fill, *_work;
+  q15_t _raw[2][FRAME*DECIMATE];	/* the same frames undecimated */
+  q15_t *_rawFill, *_rawWork;
+  float _dip;
+  int _nfill, _step;
+  q63_t _d[LAGS];
+  q63_t _energy0, _energy, _minPower;
+  float _threshold;
+  volatile float _frequency, _probability;
+  volatile uint8_t _available;
+};
+
+/* 15 tap hamming windowed lowpass, -3dB at 0.18 of the input rate, unity gain */
+q15_t AudioAnalyzePitch::_coeffs[TAPS] = {
+  22, 217, 163, -962, -1625, 2074, 9626, 13738, 9626, 2074, -1625, -962, 163, 217, 22
+};
+
+#endif // AudioAnalyzePitch_h
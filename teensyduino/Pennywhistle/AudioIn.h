@@ -34,9 +34,29 @@
 ** Nothing else is required, 
 ** other than soft wiring the I2S input to the Teensy Audio library.
 ** and enabling the mixer that combines the left and right channels.
+**
+** The left channel also feeds the breath envelope follower,
+** and the conditioner on the way up the USB, set up here from
+** Config.h.
 */
+#include "AudioAnalyzeBreath.h"
+#include "AudioConditionMic.h"
+
 namespace AudioIn {
-  int begin() { return 1; }
+  int begin(AudioAnalyzeBreath &breath) {
+    breath.attack(MIC_BREATH_ATTACK_MS);
+    breath.release(MIC_BREATH_RELEASE_MS);
+    breath.fullScale(MIC_BREATH_FULL_SCALE);
+    breath.gate(MIC_BREATH_GATE);
+    return 1;
+  }
+  int begin(AudioConditionMic &cond) {
+    cond.highpass(MIC_HIGHPASS_HZ);
+    cond.agcTarget(MIC_AGC_TARGET);
+    cond.agcMaxGain(MIC_AGC_MAX_GAIN);
+    cond.agc(MIC_AGC_MAX_GAIN > 0);
+    return 1;
+  }
 };
 
 #endif
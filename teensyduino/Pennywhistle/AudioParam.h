@@ -0,0 +1,104 @@
+/* -*- mode: c++; tab-width: 8 -*- */
+/*
+  Copyright (C) 2018 by Roger E Critchlow Jr, Charlestown, MA, USA.
+
+  This program is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation; either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program; if not, write to the Free Software
+  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307 USA
+*/
+/*
+** A control parameter for an audio object, set from loop() at any
+** rate, ramped per sample across the next block in update().
+**
+** set() is one aligned 32 bit store into the target slot, no lock
+** and no interrupt masking, the audio update reads the slot once at
+** the top of the block with start().  Whatever was last written is
+** what the block ramps to, earlier writes since the last block are
+** simply overwritten.
+**
+** Values are Q16, so 1.0 is 65536, up to 32767.  A LINEAR parameter
+** steps by a constant each sample, an EXPONENTIAL one multiplies by
+** a constant, so gains move in even dB, down to -60dB, FLOOR, where
+** it lands on 0 at the end of the block.  The exponential runs in
+** float, a multiply and a convert per sample on the M4F, since Q16
+** loses too much at the quiet end.  Either way the next block starts
+** exactly on the target.
+**
+** In update():
+**   if (p.start()) for (n...) { int32_t g = p.next(); ... }
+**   else { int32_t g = p.value(); ... }
+*/
+#ifndef AudioParam_h
+#define AudioParam_h
+
+#include <AudioStream.h>
+#include <math.h>
+
+class AudioParam
+{
+ public:
+  enum { LINEAR, EXPONENTIAL };
+  static const int32_t ONE = 65536;
+  static const int32_t FLOOR = ONE / 1024;
+
+  AudioParam(float value = 0, uint8_t shape = LINEAR) : _shape(shape) {
+    _target = _current = _end = value * ONE;
+    _step = 0;
+  }
+
+  /* from loop(), the value to ramp to over the next block */
+  void set(float value) { _target = value * ONE; }
+  /* the value last set */
+  float get() { return (float)_target / ONE; }
+
+  /* from update(), take the target, true if this block ramps */
+  bool start() {
+    _current = _end;
+    _end = _target;
+    if (_end == _current) return false;
+    if (_shape == LINEAR) {
+      _step = (_end - _current) / AUDIO_BLOCK_SAMPLES;
+    } else {
+      int32_t from = _current > FLOOR ? _current : FLOOR, to = _end > FLOOR ? _end : FLOOR;
+      if (from == to) {
+	_current = _end;
+	return false;
+      }
+      _value = from;
+      _ratio = powf((float)to / from, 1.0f / AUDIO_BLOCK_SAMPLES);
+    }
+    return true;
+  }
+  /* the value for this sample, while ramping */
+  int32_t next() {
+    if (_shape == LINEAR) {
+      int32_t v = _current;
+      _current += _step;
+      return v;
+    }
+    int32_t v = _value;
+    _value *= _ratio;
+    return v;
+  }
+  /* the value, when not ramping */
+  int32_t value() { return _end; }
+
+ private:
+  volatile int32_t _target;	/* written by loop() */
+  int32_t _current, _end;	/* owned by update() */
+  int32_t _step;		/* Q16 per sample, linear */
+  float _value, _ratio;		/* per sample, exponential */
+  uint8_t _shape;
+};
+
+#endif // AudioParam_h
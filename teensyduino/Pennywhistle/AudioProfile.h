@@ -0,0 +1,116 @@
+/* -*- mode: c++; tab-width: 8 -*- */
+/*
+  Copyright (C) 2018 by Roger E Critchlow Jr, Charlestown, MA, USA.
+
+  This program is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation; either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program; if not, write to the Free Software
+  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307 USA
+*/
+/*
+** Per object cpu accounting for the audio graph.
+**
+** The Audio library already times each object's update(), in units
+** of 16 cycles, but only keeps the last and the largest.  This object
+** runs in the audio interrupt after the others, when declared after
+** all of them, and folds each added object's last time into a running
+** total and a log2 histogram, so a block that breaks the budget can be
+** traced to the object that broke it.  The whole update is kept as
+** the last row.
+**
+** It has no inputs or outputs, so it marks itself active to be
+** updated.  Histogram bin k counts blocks which took from 2^(k-1)
+** to 2^k units, bin 0 is under one unit.
+*/
+#ifndef AudioProfile_h
+#define AudioProfile_h
+
+#include <AudioStream.h>
+
+#ifndef AUDIO_PROFILE_NODES
+#define AUDIO_PROFILE_NODES 16
+#endif
+
+class AudioProfile : public AudioStream
+{
+ public:
+  static const int NODES = AUDIO_PROFILE_NODES;
+  static const int BINS = 16;
+  static const int UNIT = 16;		/* cycles per cpu_cycles count */
+
+  AudioProfile() : AudioStream(0, NULL) {
+    active = true;
+    _nnodes = 0;
+    reset();
+  }
+
+  /* account for node, under name */
+  void add(AudioStream &node, const char *name) {
+    if (_nnodes >= NODES) return;
+    _nodes[_nnodes] = &node;
+    _names[_nnodes] = name;
+    _nnodes += 1;
+  }
+
+  void reset() {
+    __disable_irq();
+    memset(_max, 0, sizeof(_max));
+    memset(_total, 0, sizeof(_total));
+    memset(_hist, 0, sizeof(_hist));
+    _blocks = 0;
+    __enable_irq();
+  }
+
+  virtual void update(void) {
+    for (int i = 0; i < _nnodes; i += 1)
+      tally(i, _nodes[i]->cpu_cycles);
+    // the total is only known after this update, so it lags a block
+    tally(_nnodes, AudioStream::cpu_cycles_total);
+    _blocks += 1;
+  }
+
+  /* the table for Monitor, cycles are per block, % of the block time */
+  void print() {
+    const float budget = F_CPU * (AUDIO_BLOCK_SAMPLES / AUDIO_SAMPLE_RATE_EXACT) / UNIT;
+    uint32_t blocks = _blocks;
+    Serial.printf("%lu blocks, %d cycles per block\n", (unsigned long)blocks, (int)(budget * UNIT));
+    Serial.printf("node          now    max    avg  now%%  max%%  histogram log2(cycles/%d)\n", UNIT);
+    for (int i = 0; i <= _nnodes; i += 1) {
+      uint16_t units = i < _nnodes ? _nodes[i]->cpu_cycles : AudioStream::cpu_cycles_total;
+      uint32_t avg = blocks ? _total[i] / blocks : 0;
+      Serial.printf("%-10s %6lu %6lu %6lu %5.1f %5.1f ", i < _nnodes ? _names[i] : "all",
+		    (unsigned long)units*UNIT, (unsigned long)_max[i]*UNIT, (unsigned long)avg*UNIT,
+		    100 * units / budget, 100 * _max[i] / budget);
+      for (int k = 0; k < BINS; k += 1)
+	if (_hist[i][k]) Serial.printf(" %d:%lu", k, (unsigned long)_hist[i][k]);
+      Serial.println();
+    }
+  }
+
+ private:
+  void tally(int i, uint16_t units) {
+    if (units > _max[i]) _max[i] = units;
+    _total[i] += units;
+    _hist[i][units == 0 ? 0 : min(32 - __builtin_clz(units), BINS-1)] += 1;
+  }
+
+  AudioStream *_nodes[NODES];
+  const char *_names[NODES];
+  int _nnodes;
+  /* one more row for the whole update */
+  uint16_t _max[NODES+1];
+  uint64_t _total[NODES+1];
+  uint32_t _hist[NODES+1][BINS];
+  uint32_t _blocks;
+};
+
+#endif // AudioProfile_h
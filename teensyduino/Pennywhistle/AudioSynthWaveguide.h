@@ -0,0 +1,220 @@
+/* -*- mode: c++; tab-width: 8 -*- */
+/*
+  Copyright (C) 2018 by Roger E Critchlow Jr, Charlestown, MA, USA.
+
+  This program is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation; either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program; if not, write to the Free Software
+  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307 USA
+*/
+/*
+** Waveguide whistle, after the STK Flute by Cook and Scavone,
+** in fixed point as a Teensy Audio object with no inputs.
+** Signals in the loop are Q12, so the breath can exceed 1.0 as
+** it does in the STK, and coefficients are Q15.
+**
+** The breath pressure, plus breath noise, drives a jet delay line
+** into a cubic jet nonlinearity, which feeds a bore delay line.
+** The bore output is lowpassed, inverted, and dc blocked, and
+** reflects back into both the jet and the bore input.
+**
+**   breath + noise -> (+) -> jet delay -> x(x*x-1) -> (+) -> bore delay -+-> out
+**                      ^ -jet reflection               ^ end reflection    |
+**                      +---------------------------------------------------+
+**                                            <- dc block <- -lowpass <-
+**
+** The output is dc blocked again, since the jet passes the breath.
+** The bore is tuned with a fractional delay, linear interpolation
+** on a Q16 delay, which is computed from the frequency including
+** the phase delay of the reflection lowpass and a fitted allowance
+** for the jet.  Like the STK flute it is tuned to 2/3 of the pitch
+** and sounds on the second mode.
+**
+** Budget: about 45 cycles per sample on a Cortex-M4, 6000 cycles
+** per 128 sample block, just over 1% of a 180MHz Teensy 3.6 at 44.1kHz.
+** The recursion is per sample, the output gain uses arm_scale_q15,
+** or ramps per sample, see AudioParam.h, for a block after gain().
+** When the breath has died away and the bore is quiet, update()
+** transmits nothing and costs almost nothing.
+**
+** Note and breath changes from loop() should be posted to events,
+** which applies them at their sample offsets one block later, see
+** SynthEvents.h.  The direct setters take effect at the next block.
+*/
+#ifndef AudioSynthWaveguide_h
+#define AudioSynthWaveguide_h
+
+#include <AudioStream.h>
+#include <arm_math.h>
+#include <math.h>
+#include "SynthEvents.h"
+#include "AudioParam.h"
+
+class AudioSynthWaveguideFlute : public AudioStream
+{
+ public:
+  AudioSynthWaveguideFlute() : AudioStream(0, NULL), _gain(0.3f, AudioParam::EXPONENTIAL) {
+    memset(_bore, 0, sizeof(_bore));
+    memset(_jet, 0, sizeof(_jet));
+    _wbore = _wjet = 0;
+    _breath = _breathTarget = 0;
+    _lp = _dcx = _dcy = _ox = _oy = 0;
+    _seed = 22222;
+    _gate = 0;
+    _quiet = 1;
+    noise(0.15f);
+    frequency(440.0f);
+  }
+  SynthEvents events;
+
+  /* the sounding frequency in Hz */
+  void frequency(float hz) {
+    uint32_t bore, jet;
+    delays(hz, bore, jet);
+    __disable_irq();
+    _boreDelay = bore;
+    _jetDelay = jet;
+    __enable_irq();
+  }
+  /* breath pressure, 0 to 1, sounds from about 0.55 up */
+  void breath(float level) {
+    _breathTarget = constrain(level, 0.0f, 1.0f) * 1.3f * ONE;
+  }
+  /* breath noise relative to breath, 0 to 1 */
+  void noise(float level) {
+    _noiseGain = constrain(level, 0.0f, 1.0f) * 32767.0f;
+  }
+  /* output gain, 0 to 1, ramped over the next block */
+  void gain(float level) {
+    _gain.set(constrain(level, 0.0f, 1.0f));
+  }
+  /* gate the breath, so fingerings without a note are silent */
+  void noteOn() { _gate = 1; }
+  void noteOff() { _gate = 0; }
+
+  virtual void update(void) {
+    uint32_t start = SynthEvents::block_start(micros());
+    int next = events.next_offset(start);
+    if (next == 0) next = apply(start, 0);
+    int32_t target = _gate ? _breathTarget : 0;
+    if (target == 0 && _breath == 0 && _quiet && events.empty()) return;
+    audio_block_t *block = allocate();
+    if (block == NULL) return;
+    int32_t peak = 0;
+    for (int n = 0; n < AUDIO_BLOCK_SAMPLES; n = next) {
+      if (n == next) next = apply(start, n);
+      peak |= render(block->data, n, next, _gate ? _breathTarget : 0);
+    }
+    int16_t *out = block->data;
+    _quiet = peak < 16;
+    if (_gain.start()) {
+      for (int n = 0; n < AUDIO_BLOCK_SAMPLES; n += 1)
+	out[n] = ((int32_t)out[n] * _gain.next()) >> 16;
+    } else {
+      int32_t g = _gain.value() >> 1;
+      arm_scale_q15(out, g > 32767 ? 32767 : g, 0, out, AUDIO_BLOCK_SAMPLES);
+    }
+    transmit(block);
+    release(block);
+  }
+
+ private:
+  /* the Q16 bore and jet delays for a sounding frequency in Hz */
+  static void delays(float hz, uint32_t &bore, uint32_t &jet) {
+    if (hz < 20.0f) hz = 20.0f;
+    float f = hz * 0.66666f;
+    float w = 2.0f * (float)M_PI * f / AUDIO_SAMPLE_RATE_EXACT;
+    float p = LP_POLE / 32768.0f;
+    float lpdelay = atan2f(p * sinf(w), 1.0f - p * cosf(w)) / w;
+    // the jet lengthens the loop, fitted from rendered notes at 300-2400Hz
+    float delay = AUDIO_SAMPLE_RATE_EXACT / f * 1.0163f + 1.79f - lpdelay - 1.0f;
+    if (delay > BORE_SIZE-2) delay = BORE_SIZE-2;
+    if (delay < 2.0f) delay = 2.0f;
+    bore = delay * 65536.0f;
+    jet = delay * JET_RATIO * 65536.0f;
+  }
+  /* compute out[from] up to out[to], return the or of the magnitudes */
+  int32_t render(int16_t *out, int from, int to, int32_t target) {
+    int32_t peak = 0;
+    for (int n = from; n < to; n += 1) {
+      // bore output, reflected through lowpass, inverted, dc blocked
+      int32_t bore = tap(_bore, BORE_SIZE-1, _wbore, _boreDelay);
+      _lp += ((bore - _lp) * (32768-LP_POLE)) >> 15;
+      int32_t temp = -_lp;
+      _dcy = temp - _dcx + ((_dcy * DC_POLE) >> 15);
+      _dcx = temp;
+      temp = _dcy;
+      // breath envelope plus noise
+      _breath += (target - _breath) >> 7;
+      _seed = _seed * 1664525 + 1013904223;
+      int32_t noise = ((int32_t)_seed >> 16) * _noiseGain >> 15;
+      int32_t pd = _breath + ((noise * _breath) >> 15) - ((temp * JET_REFLECTION) >> 15);
+      // jet delay and nonlinearity, x*(x*x-1) clipped to +/-1
+      _jet[_wjet++ & (JET_SIZE-1)] = sat16(pd);
+      pd = tap(_jet, JET_SIZE-1, _wjet, _jetDelay);
+      pd = constrain((pd * (((pd * pd) >> 12) - ONE)) >> 12, -ONE, ONE);
+      // into the bore with the end reflection
+      _bore[_wbore++ & (BORE_SIZE-1)] = sat16(pd + ((temp * END_REFLECTION) >> 15));
+      // dc blocked output, Q12 to Q15
+      _oy = bore - _ox + ((_oy * DC_POLE) >> 15);
+      _ox = bore;
+      int16_t y = sat16(_oy << 3);
+      out[n] = y;
+      peak |= y < 0 ? -y : y;
+    }
+    return peak;
+  }
+  /* apply the events due at sample n, return the offset of the next */
+  int apply(uint32_t start, int n) {
+    int next;
+    while ((next = events.next_offset(start)) <= n) {
+      SynthEvents::event e = events.pop(start);
+      switch (e.type) {
+      case SynthEvents::NOTE_ON: delays(e.value, _boreDelay, _jetDelay); _gate = 1; break;
+      case SynthEvents::NOTE_OFF: _gate = 0; break;
+      case SynthEvents::BREATH: breath(e.value); break;
+      case SynthEvents::FREQUENCY: delays(e.value, _boreDelay, _jetDelay); break;
+      }
+    }
+    return next;
+  }
+
+  static const int BORE_SIZE = 1024;	/* down to about 65Hz */
+  static const int JET_SIZE = 512;
+  static const int32_t ONE = 4096;	/* 1.0 in Q12 */
+  static const int32_t LP_POLE = 21299;	/* 0.65, reflection lowpass pole */
+  static const int32_t DC_POLE = 32440;	/* 0.99, dc blocker pole */
+  static const int32_t JET_REFLECTION = 16384; /* 0.5 */
+  static const int32_t END_REFLECTION = 16384; /* 0.5 */
+  static constexpr float JET_RATIO = 0.32f;
+
+  static inline int16_t sat16(int32_t x) { return x > 32767 ? 32767 : x < -32768 ? -32768 : x; }
+  /* read d/65536 samples behind the write index w */
+  static inline int32_t tap(const int16_t *buf, uint32_t mask, uint32_t w, uint32_t d) {
+    uint32_t i = w - (d >> 16);
+    int32_t a = buf[i & mask], b = buf[(i-1) & mask];
+    return a + (((b - a) * (int32_t)((d & 0xFFFF) >> 1)) >> 15);
+  }
+
+  int16_t _bore[BORE_SIZE];
+  int16_t _jet[JET_SIZE];
+  uint32_t _wbore, _wjet;
+  uint32_t _boreDelay, _jetDelay;	/* Q16 samples */
+  int32_t _breathTarget, _breath;	/* Q12 */
+  int32_t _noiseGain;			/* Q15 */
+  AudioParam _gain;
+  int32_t _lp, _dcx, _dcy, _ox, _oy;
+  uint32_t _seed;
+  uint8_t _gate, _quiet;
+};
+
+#endif // AudioSynthWaveguide_h
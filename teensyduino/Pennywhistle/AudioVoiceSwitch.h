@@ -0,0 +1,106 @@
+/* -*- mode: c++; tab-width: 8 -*- */
+/*
+  Copyright (C) 2018 by Roger E Critchlow Jr, Charlestown, MA, USA.
+
+  This program is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation; either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program; if not, write to the Free Software
+  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307 USA
+*/
+/*
+** Switch between instrument voices with a crossfade.
+**
+** Every voice is built and connected when the sketch starts, each
+** into its own input, so switching allocates nothing and changes no
+** connections.  select() takes effect at the next block boundary,
+** then the output fades linearly from the old input to the new one
+** over fadeBlocks() blocks, per sample, so there is no click.
+**
+** Outside a fade the selected input's block is passed through
+** without a copy.  During a fade one block is taken from the pool,
+** and if the pool is empty the new input is passed through instead,
+** so a block is never dropped.  Unselected inputs are received and
+** released every block, and voices left silent transmit nothing,
+** so they cost next to nothing.  The caller keeps the old voice
+** sounding until fading() is false, then silences it.
+*/
+#ifndef AudioVoiceSwitch_h
+#define AudioVoiceSwitch_h
+
+#include <AudioStream.h>
+
+class AudioVoiceSwitch : public AudioStream
+{
+ public:
+  static const int INPUTS = 4;
+
+  AudioVoiceSwitch() : AudioStream(INPUTS, inputQueueArray) {
+    _from = _current = _next = 0;
+    _fade = 0;
+    _fadeBlocks = 2;
+  }
+  /* switch to input at the next block */
+  void select(uint8_t input) { if (input < INPUTS) _next = input; }
+  uint8_t selected() { return _next; }
+  /* true until the last select() has taken effect and its fade is done */
+  bool fading() { return _next != _current || _fade != 0; }
+  /* crossfade length, 1 to 16 blocks of 2.9ms */
+  void fadeBlocks(uint8_t n) { _fadeBlocks = constrain(n, 1, 16); }
+
+  virtual void update(void) {
+    audio_block_t *in[INPUTS];
+    for (int i = 0; i < INPUTS; i += 1) in[i] = receiveReadOnly(i);
+    if (_fade == 0 && _next != _current) {
+      _from = _current;
+      _current = _next;
+      _fade = _fadeBlocks;
+    }
+    audio_block_t *out = NULL;
+    if (_fade != 0) {
+      out = fade(in[_from], in[_current]);
+      _fade -= 1;
+    }
+    if (out == NULL && in[_current] != NULL) {
+      out = in[_current];
+      in[_current] = NULL;
+    }
+    if (out != NULL) {
+      transmit(out);
+      release(out);
+    }
+    for (int i = 0; i < INPUTS; i += 1)
+      if (in[i] != NULL) release(in[i]);
+  }
+
+ private:
+  /* one block of the fade, a missing input is silence, NULL if both are */
+  audio_block_t *fade(audio_block_t *a, audio_block_t *b) {
+    if (a == NULL && b == NULL) return NULL;
+    audio_block_t *out = allocate();
+    if (out == NULL) return NULL;
+    // gain of b in Q14, ramping across this block's share of the fade
+    int32_t step = 16384 / (_fadeBlocks * AUDIO_BLOCK_SAMPLES);
+    int32_t g = (_fadeBlocks - _fade) * AUDIO_BLOCK_SAMPLES * step;
+    for (int n = 0; n < AUDIO_BLOCK_SAMPLES; n += 1, g += step) {
+      int32_t x = a ? a->data[n] : 0, y = b ? b->data[n] : 0;
+      out->data[n] = x + (((y - x) * g) >> 14);
+    }
+    return out;
+  }
+
+  audio_block_t *inputQueueArray[INPUTS];
+  uint8_t _from;
+  volatile uint8_t _current, _next, _fade;
+  uint8_t _fadeBlocks;
+};
+
+#endif // AudioVoiceSwitch_h
@@ -0,0 +1,125 @@
+/* -*- mode: c++; tab-width: 8 -*- */
+/*
+  Copyright (C) 2018 by Roger E Critchlow Jr, Charlestown, MA, USA.
+
+  This program is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation; either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program; if not, write to the Free Software
+  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307 USA
+*/
+/*
+** Breath bends the pitch, as a whistle goes sharp when blown
+** harder and flat when blown softly.
+**
+** Each degree of the scale has its bend at full breath, in cents,
+** and the bend is in proportion to the breath above or below the
+** center(), where the note is in tune, times depth():
+**   cents = depth * degree_cents * (level - center) / (1 - center)
+** When the scale changes, scale() compiles this into a cents per
+** breath slope for every MIDI note, accidentals taking the degree
+** below, so the note's bend costs a lookup and a multiply.
+**
+** bend() turns cents into a 14 bit pitch bend for a receiver whose
+** bend range is range() semitones, and due() limits them to one per
+** interval() microseconds, except at a note onset, so a held note
+** doesn't flood the USB with bends.  The onboard voice takes the
+** cents through Midi::hertz(), no pow().
+**
+** The degree cents are set all at once by depth(), or one by one
+** from SysEx with degrees(), 64 for none, for scales of up to
+** Midi::MaxDegrees.
+*/
+#ifndef BreathBend_h
+#define BreathBend_h
+
+#include "Midi.h"
+
+namespace BreathBend {
+  static int8_t _degree[Midi::MaxDegrees];	/* cents at full breath, for each degree */
+  static float _slope[128];		/* cents per full breath, for each note */
+  static float _center = 0.4f, _depth = 1.0f;
+  static uint8_t _root, _type, _degrees, _range = 2;
+  static uint32_t _interval = 10000;
+  static uint16_t _sent = 8192;
+  static uint32_t _sentStamp, _sends, _held;
+
+  /* compile the note slopes for a root and scale type, see Midi::scale() */
+  void scale(uint8_t root, uint8_t type) {
+    uint8_t notes[Midi::MaxDegrees];
+    _root = root;
+    _type = type;
+    _degrees = Midi::scale(root, type, notes);
+    for (int note = 0; note < 128; note += 1) {
+      // the degree at or below the note's pitch class
+      int degree = 0, best = 12;
+      for (int i = 0; i < _degrees; i += 1) {
+	int below = (note - notes[i] + 120) % 12;
+	if (below < best) { best = below; degree = i; }
+      }
+      _slope[note] = _depth * _degree[degree] / (1.0f - _center);
+    }
+  }
+
+  /* the breath level, 0 to 1, where notes are in tune */
+  void center(float c) { _center = constrain(c, 0.0f, 0.9f); scale(_root, _type); }
+  /* scale every degree's bend */
+  void depth(float d) { _depth = constrain(d, 0.0f, 4.0f); scale(_root, _type); }
+  /* the receiver's pitch bend range in semitones */
+  void range(uint8_t semitones) { _range = constrain(semitones, 1, 24); }
+  /* the least time between pitch bends, in milliseconds */
+  void interval(uint32_t ms) { _interval = constrain(ms, 1u, 1000u) * 1000; }
+  /* the cents at full breath of the first n degrees from 7 bit values, 64 is none, false if none or too many */
+  bool degrees(const uint8_t *cents, int n) {
+    if (n < 1 || n > Midi::MaxDegrees) return false;
+    for (int i = 0; i < n; i += 1) _degree[i] = (cents[i] & 0x7F) - 64;
+    scale(_root, _type);
+    return true;
+  }
+
+  /* the bend of a note at a breath level, in cents */
+  inline float cents(uint8_t note, float level) { return _slope[note & 127] * (level - _center); }
+  /* cents as a 14 bit pitch bend, 8192 in the middle */
+  inline uint16_t bend(float cents) {
+    int32_t b = 8192 + (int32_t)(cents * 8192.0f / (_range * 100));
+    return constrain(b, 0, 16383);
+  }
+  /* true if the bend should be sent at stamp micros, and takes it as sent */
+  bool due(uint16_t value, uint32_t stamp, bool onset) {
+    if (value == _sent) return false;
+    if ( ! onset && stamp - _sentStamp < _interval) {
+      _held += 1;
+      return false;
+    }
+    _sent = value;
+    _sentStamp = stamp;
+    _sends += 1;
+    return true;
+  }
+
+  int begin() {
+    for (int i = 0; i < Midi::MaxDegrees; i += 1) _degree[i] = BEND_CENTS;
+    _center = BEND_CENTER;
+    range(BEND_RANGE);
+    interval(BEND_INTERVAL_MS);
+    scale(ROOTNOTE, SCALETYPE);
+    return 1;
+  }
+  void report() {
+    Serial.printf("breath bend center %4.2f depth %4.2f range %d interval %lums, cents by degree:",
+		  _center, _depth, _range, (unsigned long)_interval / 1000);
+    for (int i = 0; i < _degrees; i += 1) Serial.printf(" %+d", _degree[i]);
+    Serial.printf("\nbend %d, sent %lu, held back %lu\n", _sent - 8192, (unsigned long)_sends, (unsigned long)_held);
+    _sends = _held = 0;
+  }
+};
+
+#endif // BreathBend_h
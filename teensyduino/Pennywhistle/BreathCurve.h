@@ -0,0 +1,104 @@
+/* -*- mode: c++; tab-width: 8 -*- */
+/*
+  Copyright (C) 2018 by Roger E Critchlow Jr, Charlestown, MA, USA.
+
+  This program is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation; either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program; if not, write to the Free Software
+  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307 USA
+*/
+/*
+** The response curve from breath level to expression, shared by the
+** breath controller messages and the onboard voices.
+**
+** The curve is compiled into a table of SEGMENTS+1 Q15 points, and
+** map() interpolates linearly between them, a shift, a mask, and a
+** multiply, so it is cheap enough to run per sample.  It is compiled
+** either from a shape, a dead zone, a gamma, and the level where it
+** saturates,
+**   y = ((x - dead) / (sat - dead)) ^ gamma, clipped to 0..1
+** or from a list of 7 bit x, y points, sent by SysEx, joined by
+** straight lines and level beyond the ends.  Corners between table
+** points are cut, by at most 1/32 of the input range.
+**
+** Compiling takes a few dozen powf()s and happens in loop(), which is
+** also the only place map() is called from, so no locking.
+*/
+#ifndef BreathCurve_h
+#define BreathCurve_h
+
+namespace BreathCurve {
+  static const int SEGMENTS = 32;
+  static const int SHIFT = 10;		/* 15 - log2(SEGMENTS) */
+
+  static uint16_t _table[SEGMENTS+1];
+  static float _dead, _gamma, _sat;
+  static uint8_t _points;		/* compiled from points, not the shape */
+
+  /* compile from a dead zone, gamma, and saturation, all 0 to 1 of breath but gamma */
+  void shape(float dead, float gamma, float sat) {
+    _dead = constrain(dead, 0.0f, 0.9f);
+    _gamma = constrain(gamma, 0.125f, 8.0f);
+    _sat = constrain(sat, _dead + 0.05f, 1.0f);
+    _points = 0;
+    for (int i = 0; i <= SEGMENTS; i += 1) {
+      float x = (float)i / SEGMENTS;
+      float y = x <= _dead ? 0.0f : x >= _sat ? 1.0f : powf((x - _dead) / (_sat - _dead), _gamma);
+      _table[i] = y * 32767.0f;
+    }
+  }
+
+  /* compile from len bytes of x, y pairs of 7 bit values, x ascending, false if they aren't */
+  bool points(const uint8_t *xy, int len) {
+    if (len < 2 || (len & 1)) return false;
+    int n = len / 2;
+    for (int j = 0; j < 2*n; j += 1)
+      if (xy[j] > 127 || (j >= 2 && (j & 1) == 0 && xy[j] <= xy[j-2])) return false;
+    for (int i = 0, j = 0; i <= SEGMENTS; i += 1) {
+      int x = i * 127 / SEGMENTS;
+      while (j < n && xy[2*j] < x) j += 1;
+      int y;
+      if (j == 0) y = xy[1] * 258;
+      else if (j == n) y = xy[2*n-1] * 258;
+      else {
+	int x0 = xy[2*j-2], y0 = xy[2*j-1], x1 = xy[2*j], y1 = xy[2*j+1];
+	y = (y0 * 258 * (x1 - x) + y1 * 258 * (x - x0)) / (x1 - x0);
+      }
+      _table[i] = min(y, 32767);
+    }
+    _points = 1;
+    return true;
+  }
+
+  /* breath, Q15, through the curve, Q15 */
+  inline int32_t map(int32_t x) {
+    if (x <= 0) return _table[0];
+    if (x >= 32767) return _table[SEGMENTS];
+    int i = x >> SHIFT, f = x & ((1 << SHIFT) - 1);
+    return _table[i] + (((_table[i+1] - _table[i]) * f) >> SHIFT);
+  }
+  /* the same, 0 to 1 */
+  float map(float level) { return map((int32_t)(level * 32767.0f)) / 32767.0f; }
+
+  int begin() {
+    shape(BREATH_DEAD_ZONE, BREATH_GAMMA, BREATH_SATURATION);
+    return 1;
+  }
+  void report() {
+    if (_points) Serial.printf("breath curve from points:");
+    else Serial.printf("breath curve dead %4.2f gamma %4.2f sat %4.2f:", _dead, _gamma, _sat);
+    for (int i = 0; i <= SEGMENTS; i += 4) Serial.printf(" %d", _table[i] >> 8);
+    Serial.printf("\n");
+  }
+};
+
+#endif // BreathCurve_h
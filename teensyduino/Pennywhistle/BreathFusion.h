@@ -0,0 +1,119 @@
+/* -*- mode: c++; tab-width: 8 -*- */
+/*
+  Copyright (C) 2018 by Roger E Critchlow Jr, Charlestown, MA, USA.
+
+  This program is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation; either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program; if not, write to the Free Software
+  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307 USA
+*/
+/*
+** One breath level from the microphone and the barometer.
+**
+** The microphone envelope arrives every audio block, 2.9ms, and
+** moves as soon as the breath does, but its scale depends on how
+** the player blows across it.  The barometer arrives at its own
+** conversion rate, tens of ms, and is slow but absolute.
+**
+** This is a complementary filter run from loop(): each mic update
+** moves the estimate by the change in the mic envelope, times a
+** gain, and each barometer update pulls the estimate a fraction,
+** BREATH_BARO_WEIGHT, of the way to the barometer.  So the fast
+** part of the estimate comes from the mic and the steady part from
+** the barometer.  The gain is learned as the ratio of barometer to
+** mic while both are up, so the mic's scale doesn't matter.
+**
+** For tuning, report() gives
+**   lead  - how much sooner, on average and at most, the estimate
+**           crosses the onset level than the barometer does
+**   innov - rms of barometer minus estimate, at barometer updates
+**   idle  - rms of the estimate while neither sensor sees breath
+*/
+#ifndef BreathFusion_h
+#define BreathFusion_h
+
+namespace BreathFusion {
+  static const float ONSET = 0.1f;	/* the level counted as an onset */
+  static const float GATE = 0.02f;	/* below this a sensor sees no breath */
+
+  static float _level, _mic, _baro, _gain = 1.0f;
+  static uint32_t _stamp;
+
+  // onset timing, microseconds
+  static uint32_t _fusedOnset, _baroOnset;
+  static uint8_t _armed = 1;
+  static uint32_t _onsets;
+  static int64_t _leadSum;
+  static int32_t _leadMax;
+  // noise, sums of squares
+  static float _innovSum, _idleSum;
+  static uint32_t _innovCount, _idleCount;
+
+  static void onset() {
+    if (_armed && _level >= ONSET && _fusedOnset == 0) _fusedOnset = _stamp;
+    if (_armed && _baro >= ONSET && _baroOnset == 0) _baroOnset = _stamp;
+    if (_armed && _fusedOnset != 0 && _baroOnset != 0) {
+      int32_t lead = _baroOnset - _fusedOnset;
+      _onsets += 1;
+      _leadSum += lead;
+      if (lead > _leadMax) _leadMax = lead;
+      _armed = 0;
+    }
+    if ( ! _armed && _level < ONSET/2 && _baro < ONSET/2) {
+      _armed = 1;
+      _fusedOnset = _baroOnset = 0;
+    }
+  }
+
+  /* the mic envelope, 0 to 1, and the micros() it was taken */
+  void mic(float level, uint32_t stamp) {
+    _level = constrain(_level + _gain * (level - _mic), 0.0f, 1.0f);
+    _mic = level;
+    _stamp = stamp;
+    if (_mic < GATE && _baro < GATE) {
+      _idleSum += _level * _level;
+      _idleCount += 1;
+    }
+    onset();
+  }
+
+  /* the barometer breath, 0 to 1, and the micros() it was taken */
+  void baro(float level, uint32_t stamp) {
+    float innov = level - _level;
+    _innovSum += innov * innov;
+    _innovCount += 1;
+    _level = constrain(_level + BREATH_BARO_WEIGHT * innov, 0.0f, 1.0f);
+    _baro = level;
+    _stamp = stamp;
+    if (_mic > GATE && _baro > GATE)
+      _gain = constrain(_gain + 0.05f * (_baro / _mic - _gain), 0.25f, 4.0f);
+    onset();
+  }
+
+  float level() { return _level; }
+  bool micIdle() { return _mic < GATE; }
+  uint32_t stamp() { return _stamp; }
+  float gain() { return _gain; }
+
+  void report() {
+    Serial.printf("breath %5.3f, mic %5.3f, baro %5.3f, gain %5.2f\n", _level, _mic, _baro, _gain);
+    Serial.printf("onsets %lu, lead avg %ldus max %ldus\n", (unsigned long)_onsets,
+		  _onsets ? (long)(_leadSum / _onsets) : 0L, (long)_leadMax);
+    Serial.printf("innov rms %6.4f, idle rms %6.4f\n",
+		  _innovCount ? sqrtf(_innovSum / _innovCount) : 0.0f,
+		  _idleCount ? sqrtf(_idleSum / _idleCount) : 0.0f);
+    _onsets = 0; _leadSum = 0; _leadMax = 0;
+    _innovSum = _idleSum = 0; _innovCount = _idleCount = 0;
+  }
+};
+
+#endif // BreathFusion_h
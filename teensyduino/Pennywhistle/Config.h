@@ -40,6 +40,10 @@
 #ifndef USEBINARY
 #define USEBINARY false
 #endif
+/* the semitones the thumbholes shift, 12 for registers, 7 for fifths */
+#ifndef THUMB_SHIFT
+#define THUMB_SHIFT 12
+#endif
 /*
   This define specifies the number of array
   elements in TouchPads and selects one of
@@ -74,10 +78,65 @@
 #define HARDWARE_AVERAGING 0
 #endif
 
+/*
+  this define selects DMA batch scanning of the
+  touch pads on Teensy 3.x, one scan every
+  TOUCH_BATCH_PERIOD microseconds, see Teensy3Touch.h,
+  0 scans from the end of scan interrupt instead
+*/
+#ifndef TOUCH_BATCH_PERIOD
+#define TOUCH_BATCH_PERIOD 0
+#endif
+
+/*
+  this define selects fixed rate scanning of the
+  touch pads, one scan every TOUCH_SCAN_PERIOD
+  microseconds from an IntervalTimer, 0 scans
+  again as soon as each scan ends
+*/
+#ifndef TOUCH_SCAN_PERIOD
+#define TOUCH_SCAN_PERIOD 0
+#endif
+
+/*
+  this define selects adaptive scheduling of
+  the touch pads on Teensy LC, every TOUCH_ADAPTIVE'th
+  measurement goes round robin and the rest go to the
+  pads which are changing, see Teensy3Touch.h,
+  0 for plain round robin
+*/
+#ifndef TOUCH_ADAPTIVE
+#define TOUCH_ADAPTIVE 0
+#endif
+
 #ifndef SOFTWARE_AVERAGING
 #define SOFTWARE_AVERAGING 0
 #endif
 
+/*
+  these defines specify the per pad filter
+  applied to raw touch counts, see padfilter.h,
+  median of 3 on or off, filter type 0 none,
+  1 one pole, or 2 biquad, cutoff as 1/256 of
+  the scan rate, and biquad Q as 1/16; the
+  median of 3 adds one scan of latency to every pad
+*/
+#ifndef PAD_FILTER_MEDIAN
+#define PAD_FILTER_MEDIAN 1
+#endif
+
+#ifndef PAD_FILTER_TYPE
+#define PAD_FILTER_TYPE 0
+#endif
+
+#ifndef PAD_FILTER_CUTOFF
+#define PAD_FILTER_CUTOFF 32
+#endif
+
+#ifndef PAD_FILTER_Q
+#define PAD_FILTER_Q 11
+#endif
+
 /*
   this define specifies the 
   the normalized threshold
@@ -97,6 +156,191 @@
 #define DEBOUNCER_STEPS 31
 #endif
 
+/*
+  this define specifies the breath pressure above
+  ambient, in Pascals, which counts as full breath
+*/
+#ifndef BREATH_FULL_SCALE
+#define BREATH_FULL_SCALE 1000
+#endif
+
+/*
+  the ambient pressure follows the barometer while the mic
+  hears no breath, over 2^BREATH_AMBIENT_SHIFT readings,
+  about 5s at the BMP280's rate
+*/
+#ifndef BREATH_AMBIENT_SHIFT
+#define BREATH_AMBIENT_SHIFT 7
+#endif
+
+/*
+  this define specifies how many audio objects the
+  per object cpu accounting has room for
+*/
+#ifndef AUDIO_PROFILE_NODES
+#define AUDIO_PROFILE_NODES 16
+#endif
+
+/*
+  these defines set up the breath envelope taken
+  from the microphone: attack and release times in
+  milliseconds, the rms, as a fraction of digital
+  full scale, which counts as full breath, and the
+  gate level as a fraction of full breath
+*/
+#ifndef MIC_BREATH_ATTACK_MS
+#define MIC_BREATH_ATTACK_MS 3
+#endif
+#ifndef MIC_BREATH_RELEASE_MS
+#define MIC_BREATH_RELEASE_MS 60
+#endif
+#ifndef MIC_BREATH_FULL_SCALE
+#define MIC_BREATH_FULL_SCALE 0.25
+#endif
+#ifndef MIC_BREATH_GATE
+#define MIC_BREATH_GATE 0.02
+#endif
+
+/*
+  these defines set up the conditioning of the
+  microphone sent up the USB: the high pass cutoff
+  in Hz, 0 for none, the peak level the automatic
+  gain aims for as a fraction of digital full scale,
+  and the most gain it will apply, 0 for no agc
+*/
+#ifndef MIC_HIGHPASS_HZ
+#define MIC_HIGHPASS_HZ 80
+#endif
+#ifndef MIC_AGC_TARGET
+#define MIC_AGC_TARGET 0.25
+#endif
+#ifndef MIC_AGC_MAX_GAIN
+#define MIC_AGC_MAX_GAIN 16
+#endif
+
+/*
+  this define sets the gain into the headphone or
+  speaker amp at full channel volume, control 7
+*/
+#ifndef AUDIO_OUT_GAIN
+#define AUDIO_OUT_GAIN 0.03125
+#endif
+
+/*
+  this define sets how far each barometer reading
+  pulls the fused breath level toward it, the rest
+  of the breath level comes from the microphone
+*/
+#ifndef BREATH_BARO_WEIGHT
+#define BREATH_BARO_WEIGHT 0.25
+#endif
+
+/*
+  these defines shape the response from breath level
+  to the breath controller and the onboard voices:
+  the dead zone and the saturation level, both as a
+  fraction of full breath, and the gamma in between
+*/
+#ifndef BREATH_DEAD_ZONE
+#define BREATH_DEAD_ZONE 0.05
+#endif
+#ifndef BREATH_GAMMA
+#define BREATH_GAMMA 1.0
+#endif
+#ifndef BREATH_SATURATION
+#define BREATH_SATURATION 0.9
+#endif
+
+/*
+  these defines set the One Euro smoothing of the
+  barometer's breath level: the cutoff in Hz while
+  the breath holds steady, how much the cutoff rises,
+  in Hz per full breath per second, as it moves, and
+  the cutoff in Hz for the measure of how fast it moves
+*/
+#ifndef BREATH_EURO_MIN_CUTOFF
+#define BREATH_EURO_MIN_CUTOFF 1.0
+#endif
+#ifndef BREATH_EURO_BETA
+#define BREATH_EURO_BETA 3.0
+#endif
+#ifndef BREATH_EURO_D_CUTOFF
+#define BREATH_EURO_D_CUTOFF 3.0
+#endif
+
+/*
+  these defines set the tonguing detector: how far
+  a stop dips, as a fraction of the held breath, how
+  fast it must fall, in full breath per second, and
+  how much of the dip the breath must recover before
+  the note sounds again
+*/
+#ifndef ARTICULATION_DEPTH
+#define ARTICULATION_DEPTH 0.3
+#endif
+#ifndef ARTICULATION_SLOPE
+#define ARTICULATION_SLOPE 3.0
+#endif
+#ifndef ARTICULATION_RECOVER
+#define ARTICULATION_RECOVER 0.5
+#endif
+
+/*
+  these defines set overblowing, for six and seven
+  pads: the breath level which jumps to the upper
+  register, and the lower level which falls back
+*/
+#ifndef OVERBLOW_UP
+#define OVERBLOW_UP 0.6
+#endif
+#ifndef OVERBLOW_DOWN
+#define OVERBLOW_DOWN 0.45
+#endif
+
+/*
+  this define sets the tuning, the frequency
+  of A 440 in Hz
+*/
+#ifndef TUNING_A4
+#define TUNING_A4 440.0
+#endif
+
+/*
+  these defines set the breath's pitch bend: the
+  cents sharp at full breath, for every degree of the
+  scale, the breath level where notes are in tune,
+  the receiver's bend range in semitones, and the
+  least time between pitch bend messages
+*/
+#ifndef BEND_CENTS
+#define BEND_CENTS 30
+#endif
+#ifndef BEND_CENTER
+#define BEND_CENTER 0.4
+#endif
+#ifndef BEND_RANGE
+#define BEND_RANGE 2
+#endif
+#ifndef BEND_INTERVAL_MS
+#define BEND_INTERVAL_MS 10
+#endif
+
+/*
+  these defines set the onset velocity: how long the
+  breath's rise is measured, the most latency that may
+  add to a NoteOn, both in milliseconds, and the rise,
+  in full breath per second, for velocity 127
+*/
+#ifndef VELOCITY_WINDOW_MS
+#define VELOCITY_WINDOW_MS 6
+#endif
+#ifndef VELOCITY_CAP_MS
+#define VELOCITY_CAP_MS 10
+#endif
+#ifndef VELOCITY_FULL
+#define VELOCITY_FULL 25.0
+#endif
+
 // ** NRPN 4 -> reset
 
 #define NPRN_NOTE	0		/* base note non-registered parameter number */
@@ -110,11 +354,41 @@
 #define NPRN_PRESCALE	8		/* TSI prescale non-registered parameter number */
 #define NPRN_NPADS	9		/* number of pads non-registered parameter number */
 #define NPRN_FINGER    10		/* fingering scheme non-registered parameter number */
+#define NPRN_EURO_MIN_CUTOFF 11		/* breath smoothing cutoff, value/100 Hz */
+#define NPRN_EURO_BETA 12		/* breath smoothing speed gain, value/100 Hz per full breath per second */
+#define NPRN_EURO_D_CUTOFF 13		/* breath smoothing speed cutoff, value/100 Hz */
+#define NPRN_TONGUE_DEPTH 14		/* tonguing dip depth, value/1000 of the held breath */
+#define NPRN_TONGUE_SLOPE 15		/* tonguing fall rate, value/100 full breath per second */
+#define NPRN_TONGUE_RECOVER 16		/* tonguing recovery, value/1000 of the dip */
+#define NPRN_OVERBLOW_UP 17		/* overblow threshold, value/1000 of full breath */
+#define NPRN_OVERBLOW_DOWN 18		/* overblow fall back threshold, value/1000 of full breath */
+#define NPRN_BEND_CENTER 19		/* breath bend in tune level, value/1000 of full breath */
+#define NPRN_BEND_DEPTH 20		/* breath bend depth, value/100 of the degree cents */
+#define NPRN_BEND_RANGE 21		/* receiver's pitch bend range, semitones, the msb alone */
+#define NPRN_BEND_INTERVAL 22		/* least time between pitch bends, the 14 bit value in milliseconds */
+#define NPRN_VELOCITY_WINDOW 23		/* onset velocity measuring window, milliseconds, the msb alone */
+#define NPRN_VELOCITY_CAP 24		/* onset velocity latency cap, milliseconds, the msb alone */
+#define NPRN_VELOCITY_FULL 25		/* onset velocity rise for 127, value/10 full breath per second */
+#define NPRN_TUNING 26			/* tuning, value/10 Hz for A 440 */
+
+/*
+** system exclusive messages, F0 SYSEX_ID type ... F7
+*/
+#define SYSEX_ID	0x7D		/* non-commercial manufacturer id */
+#define SYSEX_BREATH_CURVE 1		/* breath curve, x y pairs of 7 bits */
+#define SYSEX_BEND_DEGREES 2		/* breath bend cents at full breath for each degree, 64 is none */
+#define SYSEX_TUNING	3		/* tuning table, key semitone msb lsb for each key, see Tuning.h */
 
 /* disable parts looking for broken stuff */
 #define TOUCHPADS_ENABLED 1
 #define FINGERING_ENABLED 1
 #define PRESSURE_ENABLED 1
 #define MIDI_INPUT_ENABLED 1
+#define SYNTH_ENABLED 1
+#define ARTICULATION_ENABLED 1
+#define OVERBLOW_ENABLED 1
+#define BEND_ENABLED 1
+#define VELOCITY_ENABLED 1
+#define AUDIO_PROFILE_ENABLED 1
 #endif // config_h
 
@@ -57,7 +57,8 @@
 ** 0x3b 0b110000 -> sol,
 ** 0x3a 0b100000 -> la,
 ** 0x39 0b000000 -> ti,
-** use the thumbholes to select the register.
+** use the thumbholes to select the register, or
+** without thumbholes overblow, see set_register().
 **
 ** 1) Take the six keys, assign them to the bits in
 ** a byte starting from the least significant bit at
@@ -114,6 +115,20 @@
 **     0b10?????? root_note up a fifth,
 **     0b01?????? root_note down a fifth,
 **     0b00?????? and mute=0
+** The thumbholes shift by THUMB_SHIFT semitones, 12 for
+** the register, 7 for the fifths.
+**
+** Scales have any number of degrees, up to Midi::MaxDegrees,
+** a fingering which reaches past the last degree goes on into
+** the next octave, so the natural fingering of a pentatonic
+** scale plays two notes of the next octave before the cross
+** fingered octave of the root.
+**
+** Whichever fingering, set_scale() runs it once for every
+** touch vector, for both overblown registers, into a table,
+** so translate() is a single load, and a new scale takes
+** effect at the next touch, or on the next translate() of
+** the last one.
 */
 #ifndef Fingering_h
 #define Fingering_h
@@ -125,11 +140,16 @@ class Fingering {
  protected:
   Fingering() {}				// no instance
 
-  static uint8_t scale[7];
+  static const uint16_t NMASKS = 1 << NPADS;
+
+  static uint8_t scale[Midi::MaxDegrees];
+  static uint8_t degrees;
   static uint8_t root_note;
   static uint8_t scale_type;
+  static uint8_t table[2][NMASKS];	/* the note of every touch vector, in either register */
 
   static uint8_t last_note;
+  static uint8_t overblown;
 
  public:
   static void begin() { begin(ROOTNOTE, SCALETYPE); }
@@ -141,31 +161,47 @@ class Fingering {
   static void set_scale(uint8_t root, uint8_t type) {
 	root_note = root;
 	scale_type = type;
-	Midi::scale(root, type, scale);
+	degrees = Midi::scale(root, type, scale);
+	uint8_t now = overblown;
+	for (uint8_t reg = 0; reg < 2; reg += 1) {
+	  overblown = reg;
+	  for (uint16_t mask = 0; mask < NMASKS; mask += 1)
+	    table[reg][mask] = compute(mask);
+	}
+	overblown = now;
   }
   static uint8_t get_root_note() { return root_note; }
   static uint8_t get_scale_type() { return scale_type; }
+  static uint8_t get_degrees() { return degrees; }
+  // the overblown register, 0 or 1, for natural fingering without thumbholes
+  static void set_register(uint8_t reg) { overblown = reg != 0; }
   static uint8_t translate(uint16_t finger_up) { 
+    return last_note = table[overblown][finger_up & (NMASKS-1)];
+  }
+  static uint8_t lastNote() { return last_note; }
+
+protected:
+  // the note of degree d, past the last degree into the next octaves
+  static uint8_t degree(uint8_t d) { return scale[d % degrees] + 12 * (d / degrees); }
+
+  static uint8_t compute(uint16_t finger_up) {
     if (USEBINARY)
       if (USEGRAYCODE)
 	if (USESTRONGFINGERS)
-	  return  last_note = translate_strong_finger_bits_are_gray_code(finger_up);
+	  return translate_strong_finger_bits_are_gray_code(finger_up);
 	else 
-	  return  last_note = translate_low_bits_are_gray_code(finger_up);
+	  return translate_low_bits_are_gray_code(finger_up);
       else
 	if (USESTRONGFINGERS)
-	  return  last_note = translate_strong_finger_bits_are_note(finger_up);
+	  return translate_strong_finger_bits_are_note(finger_up);
 	else
-	  return  last_note = translate_low_bits_are_note(finger_up);
+	  return translate_low_bits_are_note(finger_up);
     else
-      return last_note = translate_natural(finger_up);
+      return translate_natural(finger_up);
   }
-  static uint8_t lastNote() { return last_note; }
 
-protected:
   static uint8_t translate_low_bits_are_gray_code(uint8_t finger_up) {
 	uint8_t note;
-	uint8_t octave;
 	bool sharp = (finger_up & 16) == 0;
 	bool flat = (finger_up & 32) == 0;
 	uint8_t midi_note;
@@ -187,9 +223,7 @@ protected:
 	case 0x9: note = 14; break;
 	case 0x8: note = 15; break;
 	}
-	for (octave = 0; note >= 7; octave += 12)
-	  note -= 7;
-	midi_note = scale[note]+octave;
+	midi_note = degree(note);
 	if (flat) midi_note -= 1;
 	if (sharp) midi_note += 1;
 	return midi_note;
@@ -203,10 +237,7 @@ protected:
 	bool sharp = (finger_up & 16) == 0;
 	bool flat = (finger_up & 32) == 0;
 	uint8_t midi_note;
-	if (note == 7)
-	  midi_note = scale[0]+octave+12;
-	else
-	  midi_note = scale[note]+octave;
+	midi_note = degree(note)+octave;
 	if (flat) midi_note -= 1;
 	if (sharp) midi_note += 1;
 	return midi_note;
@@ -239,62 +270,63 @@ protected:
 #endif
     switch (octave) {
     case 3: octave = 0; break;
-    case 2: octave = +12; break;
-    case 1: octave = -12; break;
+    case 2: octave = +THUMB_SHIFT; break;
+    case 1: octave = -THUMB_SHIFT; break;
     case 0: return 255; break;
     }
+    if (overblown) octave += 12;
 #if NPADS == 8 || NPADS == 6 || NPADS == 5
     // implement first open hole sets note
     // should check for half hole to flat
     switch (note) {
     case 0b111111:
-      return scale[0]+octave;
+      return degree(0)+octave;
     case 0b111110:
-      return scale[1]+octave;
+      return degree(1)+octave;
     case 0b111100: case 0b111101:
-      return scale[2]+octave;
+      return degree(2)+octave;
     case 0b111000: case 0b111001: case 0b111010: case 0b111011: 
-      return scale[3]+octave;
+      return degree(3)+octave;
     case 0b110000: case 0b110001: case 0b110010: case 0b110011: case 0b110100: case 0b110101: case 0b110110: case 0b110111:
-      return scale[4]+octave;
+      return degree(4)+octave;
     case 0b100000: case 0b100001: case 0b100010: case 0b100011: case 0b100100: case 0b100101: case 0b100110: case 0b100111:
     case 0b101000: case 0b101001: case 0b101010: case 0b101011: case 0b101100: case 0b101101: case 0b101110: case 0b101111:
-      return scale[5]+octave;
+      return degree(5)+octave;
     case 0b000000: case 0b000001: case 0b000010: case 0b000011: case 0b000100: case 0b000101: case 0b000110: case 0b000111:
     case 0b001000: case 0b001001: case 0b001010: case 0b001011: case 0b001100: case 0b001101: case 0b001110: case 0b001111:
     case 0b010000: case 0b010001: case 0b010010: case 0b010011: case 0b010100: case 0b010101: case 0b010110: case 0b010111:
     case 0b011000: case 0b011001: case 0b011010: case 0b011011: 
-      return scale[6]+octave;
+      return degree(6)+octave;
     case 0b011100: case 0b011101: case 0b011110: case 0b011111:
-      return scale[0]+12+octave;
+      return degree(degrees)+octave;
     default: 
       return 0xFF;
     }
 #elif NPADS == 7 || NPADS == 9    
     switch (note) {
     case 0b1111111:
-      return scale[0]+octave;
+      return degree(0)+octave;
     case 0b1111110:
-      return scale[1]+octave;
+      return degree(1)+octave;
     case 0b1111100: case 0b1111101:
-      return scale[2]+octave;
+      return degree(2)+octave;
     case 0b1111000: case 0b1111001: case 0b1111010: case 0b1111011: 
-      return scale[3]+octave;
+      return degree(3)+octave;
     case 0b1110000: case 0b1110001: case 0b1110010: case 0b1110011: case 0b1110100: case 0b1110101: case 0b1110110: case 0b1110111:
-      return scale[4]+octave;
+      return degree(4)+octave;
     case 0b1100000: case 0b1100001: case 0b1100010: case 0b1100011: case 0b1100100: case 0b1100101: case 0b1100110: case 0b1100111:
     case 0b1101000: case 0b1101001: case 0b1101010: case 0b1101011: case 0b1101100: case 0b1101101: case 0b1101110: case 0b1101111:
-      return scale[5]+octave;
+      return degree(5)+octave;
     case 0b1000000: case 0b1000001: case 0b1000010: case 0b1000011: case 0b1000100: case 0b1000101: case 0b1000110: case 0b1000111:
     case 0b1001000: case 0b1001001: case 0b1001010: case 0b1001011: case 0b1001100: case 0b1001101: case 0b1001110: case 0b1001111:
     case 0b1010000: case 0b1010001: case 0b1010010: case 0b1010011: case 0b1010100: case 0b1010101: case 0b1010110: case 0b1010111:
     case 0b1011000: case 0b1011001: case 0b1011010: case 0b1011011: case 0b1011100: case 0b1011101: case 0b1011110: case 0b1011111: 
-      return scale[6]+octave;
+      return degree(6)+octave;
     case 0b0100000: case 0b0100001: case 0b0100010: case 0b0100011: case 0b0100100: case 0b0100101: case 0b0100110: case 0b0100111:
     case 0b0101000: case 0b0101001: case 0b0101010: case 0b0101011: case 0b0101100: case 0b0101101: case 0b0101110: case 0b0101111:
     case 0b0110000: case 0b0110001: case 0b0110010: case 0b0110011: case 0b0110100: case 0b0110101: case 0b0110110: case 0b0110111:
     case 0b0111000: case 0b0111001: case 0b0111010: case 0b0111011: case 0b0111100: case 0b0111101: case 0b0111110: case 0b0111111: 
-      return scale[0]+12+octave;
+      return degree(degrees)+octave;
     default:
       return 0xFF;
     }
@@ -302,8 +334,11 @@ protected:
   }
 };
 
-uint8_t Fingering::scale[7];
+uint8_t Fingering::scale[Midi::MaxDegrees];
+uint8_t Fingering::degrees;
+uint8_t Fingering::table[2][Fingering::NMASKS];
 uint8_t Fingering::root_note;
 uint8_t Fingering::scale_type;
 uint8_t Fingering::last_note;
+uint8_t Fingering::overblown;
 #endif	// Fingering_h
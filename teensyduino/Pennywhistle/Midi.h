@@ -69,6 +69,12 @@ class Midi
   static const uint8_t DorianMode = 8;				/* flat 3rd, flat 7th */
   static const uint8_t PhrygianMode = 9;			/* flat 2nd, flat 3rd, flat 6th, flat 7th */
   static const uint8_t LocrianMode = 10;			/* flat 2nd, flat 3rd, flat 5th, flat 6th, flat 7th */
+  static const uint8_t MajorPentatonic = 11;			/* 5 degrees, no 4th, no 7th */
+  static const uint8_t MinorPentatonic = 12;			/* 5 degrees, flat 3rd, no 2nd, no 6th, flat 7th */
+  static const uint8_t BluesScale = 13;				/* 6 degrees, minor pentatonic and flat 5th */
+  static const uint8_t ChromaticScale = 14;			/* 12 degrees */
+
+  static const uint8_t MaxDegrees = 12;
 
   static const uint8_t DescendingMelodicMinor = 1;
   static const uint8_t MinorScale = 1;
@@ -118,31 +124,37 @@ class Midi
 
   static int8_t note_octave(uint8_t note) { return (note/12)-1; }
 
-  static void scale(const uint8_t root, const uint8_t type, uint8_t *dest) {
+  /* the notes of a scale from root into dest, MaxDegrees long, returns the number of degrees */
+  static uint8_t scale(const uint8_t root, const uint8_t type, uint8_t *dest) {
     switch (type) {
     default: /* fall through */
-    case MajorScale: transpose(root, c_major, dest); return;
-    case NaturalMinor: transpose(root, c_natural_minor, dest); return;
-    case HarmonicMinor: transpose(root, c_harmonic_minor, dest); return;
-    case AscendingMelodicMinor: transpose(root, c_ascending_melodic_minor, dest); return;
-    case PhrygianDominant: transpose(root, c_phrygian_dominant, dest); return;
-    case DoubleHarmonic: transpose(root, c_double_harmonic, dest); return;
-    case LydianMode: transpose(root, c_lydian_mode, dest); return;
-    case MixolydianMode: transpose(root, c_mixolydian_mode, dest); return;
-    case DorianMode: transpose(root, c_dorian_mode, dest); return;
-    case PhrygianMode: transpose(root, c_phrygian_mode, dest); return;
-    case LocrianMode: transpose(root, c_locrian_mode, dest); return;
+    case MajorScale: return transpose(root, c_major, 7, dest);
+    case NaturalMinor: return transpose(root, c_natural_minor, 7, dest);
+    case HarmonicMinor: return transpose(root, c_harmonic_minor, 7, dest);
+    case AscendingMelodicMinor: return transpose(root, c_ascending_melodic_minor, 7, dest);
+    case PhrygianDominant: return transpose(root, c_phrygian_dominant, 7, dest);
+    case DoubleHarmonic: return transpose(root, c_double_harmonic, 7, dest);
+    case LydianMode: return transpose(root, c_lydian_mode, 7, dest);
+    case MixolydianMode: return transpose(root, c_mixolydian_mode, 7, dest);
+    case DorianMode: return transpose(root, c_dorian_mode, 7, dest);
+    case PhrygianMode: return transpose(root, c_phrygian_mode, 7, dest);
+    case LocrianMode: return transpose(root, c_locrian_mode, 7, dest);
+    case MajorPentatonic: return transpose(root, c_major_pentatonic, 5, dest);
+    case MinorPentatonic: return transpose(root, c_minor_pentatonic, 5, dest);
+    case BluesScale: return transpose(root, c_blues, 6, dest);
+    case ChromaticScale: return transpose(root, c_chromatic, 12, dest);
     }
   }
 
  protected:
   /* Scales */
-  static void transpose(const uint8_t new_root, const uint8_t old_root, const uint8_t *src, uint8_t *dest) {
-    for (uint8_t i = 0; i < 7; i += 1)
+  static uint8_t transpose(const uint8_t new_root, const uint8_t old_root, const uint8_t *src, uint8_t n, uint8_t *dest) {
+    for (uint8_t i = 0; i < n; i += 1)
       dest[i] = src[i] - old_root + new_root;
+    return n;
   }
-  static void transpose(const uint8_t new_root, const uint8_t *src, uint8_t *dest) {
-    transpose(new_root, src[0], src, dest);
+  static uint8_t transpose(const uint8_t new_root, const uint8_t *src, uint8_t n, uint8_t *dest) {
+    return transpose(new_root, src[0], src, n, dest);
   }
 
   /* C rooted scales and modes */
@@ -157,14 +169,59 @@ class Midi
   static const uint8_t c_dorian_mode[7];
   static const uint8_t c_phrygian_mode[];
   static const uint8_t c_locrian_mode[7];
+  static const uint8_t c_major_pentatonic[5];
+  static const uint8_t c_minor_pentatonic[5];
+  static const uint8_t c_blues[6];
+  static const uint8_t c_chromatic[12];
   
  public:
   static const float _frequency[128];
 
-  static float hertz_from_midi(uint8_t note) { return 440.0f * pow(2, (note-A_440)/12.0); }
+  /* Tuning, the frequency of A 440, which all the pitches below follow */
+  static void tuning(float a4) {
+    _a4 = constrain(a4, 220.0f, 880.0f);
+    _tune = _a4 / 440.0f;
+    _a4_increment = _a4 * (4294967296.0 / AUDIO_SAMPLE_RATE_EXACT);
+  }
+  static float tuning() { return _a4; }
+
+  static float hertz_from_midi(uint8_t note) { return hertz(note); }
 
-  static float frequency(uint8_t note) { return _frequency[note&127]; }
+  static float frequency(uint8_t note) { return _frequency[note&127] * _tune; }
 
+  /*
+  ** Fine pitch, a note bent by cents, to a frequency or to the 32 bit
+  ** phase increment per sample of an oscillator, as wave1 takes it.
+  ** The pitch goes to Q16 octaves from A 440, and the fraction of an
+  ** octave through a table of 2^x, interpolated, good to 1/20 cent,
+  ** a few multiplies, so it can run every block for bends and vibrato.
+  */
+  static float hertz(uint8_t note, float cents = 0) {
+    int32_t p = octaves(note, cents);
+    return ldexpf(_a4 * exp2_fraction(p), (p >> 16) - 30);
+  }
+  static uint32_t phase_increment(uint8_t note, float cents = 0) {
+    int32_t p = octaves(note, cents);
+    uint64_t inc = ((uint64_t)_a4_increment * exp2_fraction(p)) >> (30 - (p >> 16));
+    return inc < 0x80000000u ? inc : 0x80000000u;	/* up to nyquist */
+  }
+
+ protected:
+  static const int EXP2_SHIFT = 10;	/* 16 - log2(64 segments) */
+  static const uint32_t _exp2[65];	/* 2^(i/64), Q30 */
+  static float _a4, _tune;
+  static uint32_t _a4_increment;	/* phase increment of A 440 */
+
+  /* the pitch in Q16 octaves from A 440, within 5 octaves of a bend */
+  static int32_t octaves(uint8_t note, float cents) {
+    cents = constrain(cents, -6000.0f, 6000.0f);
+    return (int32_t)floorf(((int)(note & 127) - A_440) * (65536.0f / 12.0f) + cents * (65536.0f / 1200.0f) + 0.5f);
+  }
+  /* 2^x, Q30, of the fraction of an octave in Q16 p */
+  static uint32_t exp2_fraction(int32_t p) {
+    uint32_t f = p & 0xFFFF, i = f >> EXP2_SHIFT, t = f & ((1 << EXP2_SHIFT) - 1);
+    return _exp2[i] + (uint32_t)(((uint64_t)(_exp2[i+1] - _exp2[i]) * t) >> EXP2_SHIFT);
+  }
 };
 
 /* scales */
@@ -179,6 +236,31 @@ const uint8_t Midi::c_mixolydian_mode[] =	  { Midi::C, Midi::D,   Midi::E,   Mid
 const uint8_t Midi::c_dorian_mode[] =		  { Midi::C, Midi::D,   Midi::E-1, Midi::F,   Midi::G,   Midi::A,   Midi::B-1 };
 const uint8_t Midi::c_phrygian_mode[] =		  { Midi::C, Midi::D-1, Midi::E-1, Midi::F,   Midi::G,   Midi::A-1, Midi::B-1 };
 const uint8_t Midi::c_locrian_mode[] =		  { Midi::C, Midi::D-1, Midi::E-1, Midi::F,   Midi::G-1, Midi::A-1, Midi::B-1 };
+const uint8_t Midi::c_major_pentatonic[] =	  { Midi::C, Midi::D,   Midi::E,   Midi::G,   Midi::A };
+const uint8_t Midi::c_minor_pentatonic[] =	  { Midi::C, Midi::E-1, Midi::F,   Midi::G,   Midi::B-1 };
+const uint8_t Midi::c_blues[] =			  { Midi::C, Midi::E-1, Midi::F,   Midi::G-1, Midi::G,   Midi::B-1 };
+const uint8_t Midi::c_chromatic[] =		  { Midi::C, Midi::C_sharp, Midi::D, Midi::D_sharp, Midi::E, Midi::F,
+						    Midi::F_sharp, Midi::G, Midi::G_sharp, Midi::A, Midi::A_sharp, Midi::B };
+
+/* tuning */
+float Midi::_a4 = 440.0f;
+float Midi::_tune = 1.0f;
+uint32_t Midi::_a4_increment = 440.0 * (4294967296.0 / AUDIO_SAMPLE_RATE_EXACT);
+
+/* 2^(i/64), Q30, for fine pitch */
+const uint32_t Midi::_exp2[65] = {
+  1073741824, 1085434106, 1097253708, 1109202018, 1121280436, 1133490379,
+  1145833280, 1158310587, 1170923762, 1183674286, 1196563654, 1209593378,
+  1222764986, 1236080024, 1249540052, 1263146652, 1276901417, 1290805962,
+  1304861917, 1319070932, 1333434672, 1347954824, 1362633090, 1377471191,
+  1392470869, 1407633882, 1422962010, 1438457051, 1454120821, 1469955159,
+  1485961921, 1502142985, 1518500250, 1535035634, 1551751076, 1568648537,
+  1585730000, 1602997467, 1620452965, 1638098541, 1655936265, 1673968228,
+  1692196547, 1710623359, 1729250827, 1748081133, 1767116489, 1786359126,
+  1805811301, 1825475297, 1845353420, 1865448001, 1885761398, 1906295993,
+  1927054196, 1948038440, 1969251188, 1990694927, 2012372174, 2034285470,
+  2056437387, 2078830522, 2101467502, 2124350982, 2147483648,
+};
 
 /* commands */
 
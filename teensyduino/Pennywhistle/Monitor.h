@@ -42,12 +42,29 @@ namespace Monitor {
   static uint8_t stream_musical = 0;
   static uint8_t stream_pressure = 0;
   static uint8_t stream_touch = 0;
+  static uint8_t stream_breath = 0;
+  static uint8_t stream_pitch = 0;
   void note() { Serial.printf("%d\n", Fingering::lastNote()); }
   void musical() {
     uint8_t note = Fingering::lastNote();
     Serial.printf("%s%d ", Midi::note_name(note), Midi::note_octave(note));
   }  
-  void pressure() { Serial.printf("%7d\n", Pressure::lastPressure()); }
+  // as a trace line for host/oneeuro.cpp: ms, breath, smoothed breath, then Pascals
+  void pressure() {
+    Serial.printf("%lu breath %6.4f %6.4f %7lu\n", (unsigned long)millis(), Pressure::lastBreathLevel(),
+		  pressure_euro.value() / 65536.0f, (unsigned long)Pressure::lastPressure());
+  }
+  void breath() { Serial.printf("%6.4f %6.4f %d %6.4f\n", breath1.rms(), breath1.level(), breath1.onsets(), BreathFusion::level()); }
+  // sounded pitch from the mic against the fingered note, when there is a pitch
+  void pitch() {
+    float hz = pitch1.read();
+    uint8_t note = Fingering::lastNote();
+    Serial.printf("%7.2fHz %4.2f", hz, pitch1.probability());
+    if (note != 0xFF && hz > 0)
+      Serial.printf(" %s%d %+6.1f cents", Midi::note_name(note), Midi::note_octave(note),
+		    1200.0f * log2f(hz / Tuning::hertz(note)));
+    Serial.println();
+  }
   void touch() {
     for (int i = 0; i < NPADS; i += 1) {
       // Serial.printf("%d:%d:%d:%02x ", TouchPads::minTouch(i), TouchPads::touch(i), TouchPads::maxTouch(i), TouchPads::normTouch(i));
@@ -55,6 +72,40 @@ namespace Monitor {
     }
     Serial.println();
   }
+#if TOUCHPADS_ENABLED
+  // time PadAverage::update for 6, 9, and 16 pads,
+  // packed against scalar, and check they agree
+  void average_bench() {
+    static const int N = 16, REPS = 1000;
+    static uint16_t val[N] __attribute__((aligned(4)));
+    static uint16_t avg[2][N] __attribute__((aligned(4)));
+    static uint16_t lo[2][N] __attribute__((aligned(4)));
+    static uint16_t hi[2][N] __attribute__((aligned(4)));
+    static const int npads[] = { 6, 9, 16 };
+    ARM_DEMCR |= ARM_DEMCR_TRCENA;
+    ARM_DWT_CTRL |= ARM_DWT_CTRL_CYCCNTENA;
+    for (unsigned k = 0; k < sizeof(npads)/sizeof(npads[0]); k += 1) {
+      int n = npads[k];
+      uint32_t cycles[2] = { 0, 0 };
+      for (int j = 0; j < 2; j += 1)
+	for (int i = 0; i < N; i += 1) { avg[j][i] = 1000; lo[j][i] = 65535; hi[j][i] = 0; }
+      for (int r = 0; r < REPS; r += 1) {
+	for (int i = 0; i < N; i += 1) val[i] = 1000 + (random(2000) ^ (r & 1 ? 0x800 : 0));
+	uint32_t t0 = ARM_DWT_CYCCNT;
+	PadAverage::update_scalar(avg[0], lo[0], hi[0], val, n, 4);
+	uint32_t t1 = ARM_DWT_CYCCNT;
+	PadAverage::update(avg[1], lo[1], hi[1], val, n, 4);
+	uint32_t t2 = ARM_DWT_CYCCNT;
+	cycles[0] += t1-t0; cycles[1] += t2-t1;
+      }
+      int same = 1;
+      for (int i = 0; i < n; i += 1)
+	same &= avg[0][i] == avg[1][i] && lo[0][i] == lo[1][i] && hi[0][i] == hi[1][i];
+      Serial.printf("average %2d pads: scalar %4lu cycles, packed %4lu cycles, %s\n",
+		    n, (unsigned long)cycles[0]/REPS, (unsigned long)cycles[1]/REPS, same ? "same" : "DIFFERENT");
+    }
+  }
+#endif
 #endif // MONITOR_ACTIVE
 
   void note_stream() {
@@ -70,6 +121,16 @@ namespace Monitor {
   void pressure_stream() {
 #ifdef MONITOR_ACTIVE
     if (stream_pressure) pressure();
+#endif // MONITOR_ACTIVE
+  }
+  void breath_stream() {
+#ifdef MONITOR_ACTIVE
+    if (stream_breath) breath();
+#endif // MONITOR_ACTIVE
+  }
+  void pitch_stream() {
+#ifdef MONITOR_ACTIVE
+    if (stream_pitch) pitch();
 #endif // MONITOR_ACTIVE
   }
   void touch_stream() {
@@ -91,6 +152,19 @@ namespace Monitor {
       case 'T': stream_touch ^= 1; return;
       case 'p': pressure(); return;
       case 'P': stream_pressure ^= 1; return;
+      case 'e': breath(); return;
+      case 'E': stream_breath ^= 1; return;
+      case 'f': BreathFusion::report(); return;
+      case 'c': BreathCurve::report(); return;
+      case 'a': Articulation::report(); return;
+      case 'o': Overblow::report(); return;
+      case 'i': Tuning::report(); BreathBend::report(); return;
+      case 'l': Velocity::report(); return;
+      case 'w': pitch(); return;
+      case 'W': stream_pitch ^= 1; return;
+#if TOUCHPADS_ENABLED
+      case 'b': average_bench(); return;
+#endif
       case 'v': AudioOut::set_enabled(AudioOut::is_enabled()^1); return;
 	// case '+': AudioOut::set_gain(AudioOut::get_gain()+3); return;
 	// case '-': AudioOut::set_gain(AudioOut::get_gain()-3); return;
@@ -100,6 +174,15 @@ namespace Monitor {
 	AudioMemoryUsageMaxReset();
 	Serial.printf("AudioProcessorUsage = %f%%, AudioProcessorUsageMax = %f%%\n", AudioProcessorUsage(), AudioProcessorUsageMax());
 	AudioProcessorUsageMaxReset();
+	Serial.printf("usb mic gain %.2f, envelope %.4f\n", cond1.gain(), cond1.envelope());
+#if AUDIO_PROFILE_ENABLED
+	profile1.print();
+	profile1.reset();
+#endif
+#if TOUCHPADS_ENABLED
+	Serial.printf("touch scans = %lu, period = %luus, overruns = %lu\n", (unsigned long)TouchPads::clock(),
+		      (unsigned long)TouchPads::scan_period(), (unsigned long)Teensy3Touch::overruns());
+#endif
 	return;
       }
     }
@@ -0,0 +1,100 @@
+/* -*- mode: c++; tab-width: 8 -*- */
+/*
+  Copyright (C) 2018 by Roger E Critchlow Jr, Charlestown, MA, USA.
+
+  This program is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation; either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program; if not, write to the Free Software
+  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307 USA
+*/
+/*
+** The One Euro filter, Casiez, Roussel, and Vogel, CHI 2012, in
+** fixed point, for the barometer's breath level.
+**
+** A one pole lowpass whose cutoff rises with the speed of the
+** signal, minCutoff() plus beta() times the speed, the speed being
+** itself lowpassed at derivativeCutoff().  So a held note gets the
+** heavy smoothing of minCutoff() and an attack or release gets a
+** cutoff high enough to follow it with little lag.
+**
+** Samples are Q16, 1.0 is 65536, with their micros() stamps, since
+** the barometer's rate wanders.  Each costs two 64 bit divides, for
+** the speed and for the lowpass coefficient,
+**   alpha = w / (1 + w), w = 2 pi cutoff dt
+** Cutoffs are in Hz, beta in Hz per full scale per second.
+*/
+#ifndef OneEuroFilter_h
+#define OneEuroFilter_h
+
+class OneEuroFilter
+{
+ public:
+  OneEuroFilter() {
+    reset();
+    minCutoff(1.0f);
+    beta(3.0f);
+    derivativeCutoff(3.0f);
+  }
+  void reset() { _primed = 0; _x = _dx = 0; }
+
+  void minCutoff(float hz) { _minCutoff = constrain(hz, 0.01f, 200.0f) * ONE; }
+  void beta(float b) { _beta = constrain(b, 0.0f, 200.0f) * ONE; }
+  void derivativeCutoff(float hz) { _dCutoff = constrain(hz, 0.01f, 200.0f) * ONE; }
+  float minCutoff() { return (float)_minCutoff / ONE; }
+  float beta() { return (float)_beta / ONE; }
+  float derivativeCutoff() { return (float)_dCutoff / ONE; }
+
+  /* the next sample, Q16, taken at stamp micros, returns the filtered value */
+  int32_t filter(int32_t x, uint32_t stamp) {
+    if ( ! _primed) {
+      _primed = 1;
+      _x = x;
+      _dx = 0;
+      _stamp = stamp;
+      return _x;
+    }
+    uint32_t dt = stamp - _stamp;
+    dt = constrain(dt, 1u, 1000000u);
+    _stamp = stamp;
+    int64_t dx = (int64_t)(x - _x) * 1000000 / dt;	/* Q16 per second */
+    dx = constrain(dx, -MAX_SPEED, MAX_SPEED);
+    _dx += ((dx - _dx) * alpha(_dCutoff, dt)) >> 16;
+    int64_t speed = _dx < 0 ? -_dx : _dx;
+    int64_t cutoff = _minCutoff + ((_beta * speed) >> 16);
+    if (cutoff > MAX_CUTOFF) cutoff = MAX_CUTOFF;
+    _x += ((int64_t)(x - _x) * alpha(cutoff, dt)) >> 16;
+    return _x;
+  }
+  /* the same, 0 to 1 */
+  float filter(float x, uint32_t stamp) { return filter((int32_t)(x * ONE), stamp) / (float)ONE; }
+
+  int32_t value() { return _x; }
+
+ private:
+  static const int32_t ONE = 65536;
+  static const int64_t TWO_PI_PER_US = 26986;	/* 2 pi 1e-6, Q32 */
+  static const int64_t MAX_SPEED = 1000ll * ONE;	/* full scale in 1ms */
+  static const int64_t MAX_CUTOFF = 1000ll * ONE;	/* Hz */
+
+  /* the Q16 lowpass coefficient for a Q16 cutoff over dt microseconds */
+  static int32_t alpha(int64_t cutoff, uint32_t dt) {
+    int64_t w = (cutoff * dt * TWO_PI_PER_US) >> 32;
+    return (w << 16) / (ONE + w);
+  }
+
+  uint8_t _primed;
+  uint32_t _stamp;
+  int32_t _x, _dx;
+  int32_t _minCutoff, _beta, _dCutoff;
+};
+
+#endif // OneEuroFilter_h
@@ -0,0 +1,80 @@
+/* -*- mode: c++; tab-width: 8 -*- */
+/*
+  Copyright (C) 2018 by Roger E Critchlow Jr, Charlestown, MA, USA.
+
+  This program is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation; either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program; if not, write to the Free Software
+  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307 USA
+*/
+/*
+** Overblowing, the register chosen from the breath level, for the
+** six and seven pad fingerings which have no thumbholes to choose it.
+**
+** As on a whistle, blowing harder than up() jumps the fingered note
+** up an octave, and it stays there until the breath falls below
+** down(), which is lower, so a breath hovering near the break
+** doesn't warble between registers.  A breath which ends falls below
+** down() and the next one starts in the low register.
+**
+** update() is called with each fused breath level, before the
+** articulation detector, and returns true when the register changes,
+** so the caller translates the fingering again in the same tick and
+** the note moves straight to the new octave.  report() gives the
+** thresholds, the register, and the changes since the last report.
+*/
+#ifndef Overblow_h
+#define Overblow_h
+
+namespace Overblow {
+  static float _up = 0.6f, _down = 0.45f;
+  static uint8_t _register;
+  static uint32_t _ups, _downs;
+
+  /* the breath level, 0 to 1, which overblows into the upper register */
+  void up(float u) {
+    _up = constrain(u, 0.1f, 1.0f);
+    if (_down > _up - 0.02f) _down = _up - 0.02f;
+  }
+  /* the breath level, 0 to 1, which falls back into the lower register */
+  void down(float d) { _down = constrain(d, 0.05f, _up - 0.02f); }
+  /* the register, 0 or 1 */
+  uint8_t octave() { return _register; }
+
+  /* the breath level, 0 to 1, returns true if the register changed */
+  bool update(float level) {
+    if (_register == 0 && level >= _up) {
+      _register = 1;
+      _ups += 1;
+      return true;
+    }
+    if (_register == 1 && level < _down) {
+      _register = 0;
+      _downs += 1;
+      return true;
+    }
+    return false;
+  }
+
+  int begin() {
+    up(OVERBLOW_UP);
+    down(OVERBLOW_DOWN);
+    return 1;
+  }
+  void report() {
+    Serial.printf("overblow up %4.2f down %4.2f, register %d, %lu up %lu down\n", _up, _down, _register,
+		  (unsigned long)_ups, (unsigned long)_downs);
+    _ups = _downs = 0;
+  }
+};
+
+#endif // Overblow_h
@@ -0,0 +1,110 @@
+/* -*- mode: c++; tab-width: 8 -*- */
+/*
+  Copyright (C) 2018 by Roger E Critchlow Jr, Charlestown, MA, USA.
+
+  This program is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation; either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program; if not, write to the Free Software
+  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307 USA
+*/
+/*
+** Exponential average, minimum, and maximum of touch pad counts.
+**
+** The counts are uint16_t arrays, word aligned and padded to an
+** even length, so two pads share each 32 bit word.  On a Cortex-M4
+** the packed halfword instructions update both pads at once:
+**   uhsub16 - (val - avg) >> 1, exact in 16 bits
+**   asr     - the rest of the >> expo, split for each half
+**   uadd16  - avg += step
+**   usub16 + sel - per half min and max
+** Elsewhere, and for comparison on the Teensy, update_scalar()
+** computes the same bits one pad at a time.
+**
+** The average computed is
+**   avg + ((val - avg) >> expo)
+** which is (avg * (2^expo - 1) + val) >> expo, without the overflow.
+*/
+#ifndef PadAverage_h
+#define PadAverage_h
+
+#include <stdint.h>
+
+/* round a pad count up to whole words */
+#define PAD_WORDS(n) (((n)+1)/2)
+
+namespace PadAverage {
+
+  static const uint8_t max_expo = 15;
+
+  static void update_scalar(uint16_t *avg, uint16_t *lo, uint16_t *hi, const uint16_t *val, int n, uint8_t expo) {
+    for (int i = 0; i < n; i += 1) {
+      int32_t a = avg[i];
+      a += (int32_t)(val[i] - a) >> expo;
+      avg[i] = a;
+      if (a > hi[i]) hi[i] = a;
+      if (a < lo[i]) lo[i] = a;
+    }
+  }
+
+#if defined(__ARM_FEATURE_DSP)
+  static inline uint32_t uhsub16(uint32_t a, uint32_t b) {
+    uint32_t out;
+    asm ("uhsub16 %0, %1, %2" : "=r" (out) : "r" (a), "r" (b));
+    return out;
+  }
+  static inline uint32_t uadd16(uint32_t a, uint32_t b) {
+    uint32_t out;
+    asm ("uadd16 %0, %1, %2" : "=r" (out) : "r" (a), "r" (b));
+    return out;
+  }
+  // the usub16 sets the GE flags that the sel consumes, keep them together
+  static inline uint32_t umax16(uint32_t a, uint32_t b) {
+    uint32_t out;
+    asm ("usub16 %0, %1, %2\n\tsel %0, %1, %2" : "=&r" (out) : "r" (a), "r" (b));
+    return out;
+  }
+  static inline uint32_t umin16(uint32_t a, uint32_t b) {
+    uint32_t out;
+    asm ("usub16 %0, %1, %2\n\tsel %0, %2, %1" : "=&r" (out) : "r" (a), "r" (b));
+    return out;
+  }
+
+  static void update_packed(uint16_t *avg, uint16_t *lo, uint16_t *hi, const uint16_t *val, int n, uint8_t expo) {
+    uint32_t *a2 = (uint32_t *)avg, *lo2 = (uint32_t *)lo, *hi2 = (uint32_t *)hi;
+    const uint32_t *v2 = (const uint32_t *)val;
+    const int s = expo-1;
+    for (int i = 0; i < PAD_WORDS(n); i += 1) {
+      uint32_t a = a2[i];
+      if (expo == 0) {
+	a = v2[i];
+      } else {
+	int32_t d = uhsub16(v2[i], a);
+	uint32_t step = ((uint32_t)(d >> s) & 0xFFFF0000) | ((uint32_t)((int32_t)((uint32_t)d << 16) >> (s+16)) & 0xFFFF);
+	a = uadd16(a, step);
+      }
+      a2[i] = a;
+      hi2[i] = umax16(hi2[i], a);
+      lo2[i] = umin16(lo2[i], a);
+    }
+  }
+
+  static void update(uint16_t *avg, uint16_t *lo, uint16_t *hi, const uint16_t *val, int n, uint8_t expo) {
+    update_packed(avg, lo, hi, val, n, expo);
+  }
+#else
+  static void update(uint16_t *avg, uint16_t *lo, uint16_t *hi, const uint16_t *val, int n, uint8_t expo) {
+    update_scalar(avg, lo, hi, val, n, expo);
+  }
+#endif
+};
+
+#endif // PadAverage_h
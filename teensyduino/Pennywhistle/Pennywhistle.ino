@@ -40,19 +40,52 @@ static const char _time[] = __TIME__;
 #include <SD.h>
 #include <SerialFlash.h>
 
+#include "Config.h"
+#include "AudioSynthWaveguide.h"
+#include "AudioVoiceSwitch.h"
+#include "AudioAnalyzeBreath.h"
+#include "AudioAnalyzePitch.h"
+#include "AudioConditionMic.h"
+#include "AudioAmplifierRamp.h"
+#if AUDIO_PROFILE_ENABLED
+#include "AudioProfile.h"
+#endif
+
 // Create the Audio components.
 AudioInputI2S            i2s1;           //xy=84,77
 AudioInputUSB            usb2;           //xy=82,132
-AudioAmplifier           amp1;           //xy=234,77
-AudioAmplifier           amp2;           //xy=236,136
+#if SYNTH_ENABLED
+AudioSynthWaveguideFlute flute1;         //xy=82,187
+AudioSynthWaveform       wave1;          //xy=82,242
+AudioFilterStateVariable filt1;          //xy=160,242
+AudioAmplifierRamp       amp3;           //xy=198,242
+AudioVoiceSwitch         voice1;         //xy=236,242
+#endif
+AudioConditionMic        cond1;          //xy=234,77
+AudioAnalyzeBreath       breath1;        //xy=234,22
+AudioAnalyzePitch        pitch1;         //xy=234,-33
+AudioMixer4              mix2;           //xy=236,187
+AudioAmplifierRamp       amp2;           //xy=236,136
 AudioOutputUSB           usb1;           //xy=389,74
 AudioOutputI2S           i2s2;           //xy=393,133
-AudioConnection          patchCord2(i2s1, 0, amp1, 0);
-AudioConnection          patchCord3(amp1, 0, usb1, 0);
-AudioConnection          patchCord1(usb2, 0, amp2, 0);
+AudioConnection          patchCord2(i2s1, 0, cond1, 0);
+AudioConnection          patchCord3(cond1, 0, usb1, 0);
+AudioConnection          patchCord10(i2s1, 0, breath1, 0);
+AudioConnection          patchCord11(i2s1, 0, pitch1, 0);
+AudioConnection          patchCord1(usb2, 0, mix2, 0);
+#if SYNTH_ENABLED
+AudioConnection          patchCord5(flute1, 0, voice1, 0);
+AudioConnection          patchCord7(wave1, 0, filt1, 0);
+AudioConnection          patchCord8(filt1, 0, amp3, 0);
+AudioConnection          patchCord13(amp3, 0, voice1, 1);
+AudioConnection          patchCord9(voice1, 0, mix2, 1);
+#endif
+AudioConnection          patchCord6(mix2, 0, amp2, 0);
 AudioConnection          patchCord4(amp2, 0, i2s2, 0);
+#if AUDIO_PROFILE_ENABLED
+AudioProfile             profile1;	// after the objects it accounts for
+#endif
 
-#include "Config.h"
 #if TOUCHPADS_ENABLED
 #include "TouchPads.h"
 #endif
@@ -63,12 +96,125 @@ AudioConnection          patchCord4(amp2, 0, i2s2, 0);
 #if PRESSURE_ENABLED
 #include "Pressure.h"
 #endif
+#include "OneEuroFilter.h"
+OneEuroFilter pressure_euro;	// the barometer's breath level, smoothed
+#include "BreathFusion.h"
+#include "BreathCurve.h"
+#include "Articulation.h"
+#include "Overblow.h"
+#include "Tuning.h"
+#include "BreathBend.h"
+#include "Velocity.h"
 #include "AudioIn.h"
 #include "AudioOut.h"
 #include "Monitor.h"
 
 uint8_t pads[NPADS] = { PADS };
 
+#if SYNTH_ENABLED
+static uint8_t local_control = 1; /* play the onboard synth */
+
+/*
+** The onboard voices, all built above, selected by program change
+** through voice1, which crossfades between them:
+**   0 - the waveguide whistle, flute1
+**   1 - a sawtooth reed, wave1 through filt1 and amp3, brighter
+**       with breath
+** Notes and breath go to the selected voice only, the old one sounds
+** on through the crossfade and is then silenced, the others are
+** left silent, the reed's oscillator runs on once it has sounded
+** but the rest cost next to nothing.  The whistle takes timed
+** events, the library objects take their settings at the next block,
+** the reed's loudness ramps across it in amp3.
+*/
+static const uint8_t NVOICES = 2;
+static uint8_t synth_note = 0xFF;
+static float synth_breath = 0;
+static float synth_cents = 0;		/* the breath's bend */
+static uint8_t synth_fading = 0;	/* mask of old voices sounding through the crossfade */
+
+static void voice_note(uint8_t voice, uint32_t stamp, uint8_t note) {
+  switch (voice) {
+  case 0:
+    if (note != 0xFF)
+      flute1.events.post(stamp, SynthEvents::NOTE_ON, Tuning::hertz(note, synth_cents));
+    else
+      flute1.events.post(stamp, SynthEvents::NOTE_OFF);
+    return;
+  case 1:
+    if (note != 0xFF) {
+      wave1.frequency(Tuning::hertz(note, synth_cents));
+      wave1.amplitude(1.0);
+    }
+    amp3.gain(note != 0xFF ? synth_breath : 0);
+    return;
+  }
+}
+
+static void voice_breath(uint8_t voice, uint32_t stamp, float level) {
+  switch (voice) {
+  case 0:
+    flute1.events.post(stamp, SynthEvents::BREATH, level);
+    return;
+  case 1:
+    if (synth_note != 0xFF) amp3.gain(level);
+    filt1.frequency(300 + 3000 * level);
+    return;
+  }
+}
+
+static void voice_bend(uint8_t voice, uint32_t stamp, float cents) {
+  if (synth_note == 0xFF) return;
+  switch (voice) {
+  case 0:
+    flute1.events.post(stamp, SynthEvents::FREQUENCY, Tuning::hertz(synth_note, cents));
+    return;
+  case 1:
+    wave1.frequency(Tuning::hertz(synth_note, cents));
+    return;
+  }
+}
+
+static void synth_set_note(uint32_t stamp, uint8_t note) {
+  synth_note = note;
+  voice_note(voice1.selected(), stamp, note);
+}
+
+static void synth_set_breath(uint32_t stamp, float level) {
+  synth_breath = level;
+  voice_breath(voice1.selected(), stamp, level);
+}
+
+static void synth_set_bend(uint32_t stamp, float cents) {
+  synth_cents = cents;
+  voice_bend(voice1.selected(), stamp, cents);
+}
+
+/* bring the new voice up to the current note and breath, the old one fades out */
+static void synth_set_voice(uint8_t voice) {
+  uint8_t old = voice1.selected();
+  if (voice >= NVOICES || voice == old) return;
+  uint32_t stamp = micros();
+  synth_fading = (synth_fading | (1<<old)) & ~(1<<voice);
+  voice1.select(voice);
+  voice_breath(voice, stamp, synth_breath);
+  voice_note(voice, stamp, synth_note);
+}
+
+/* from loop(), silence the old voices once voice1 has faded them out */
+static void synth_poll(void) {
+  if (synth_fading == 0 || voice1.fading()) return;
+  uint32_t stamp = micros();
+  for (uint8_t voice = 0; voice < NVOICES; voice += 1)
+    if (synth_fading & (1<<voice)) voice_note(voice, stamp, 0xFF);
+  synth_fading = 0;
+}
+#endif
+
+#if FINGERING_ENABLED
+static void scale_set(uint8_t root, uint8_t type);	/* below, with the note */
+#endif
+
 #if MIDI_INPUT_ENABLED
 static void OnNoteOff(byte channel, byte note, byte velocity) {
   Serial.print("rcvd note on "); Serial.println(note);
@@ -96,14 +242,66 @@ static void OnNoteOn(byte channel, byte note, byte velocity) {
 **  coarse tuning, could retune the base note within the octave
 **  fine tuning, could adjust to the Teensy clock
 */
+#if TOUCHPADS_ENABLED
+static uint8_t filter_pad = 127; /* pad for filter control changes, >= NPADS for all */
+#endif
+
+/*
+** Non-registered parameters, see the NPRN_ numbers in Config.h,
+** set by control changes 0x63 and 0x62 and given a 14 bit value
+** by data entry 0x06 and 0x26.  The 7 bit parameters take the msb,
+** so data entry 0x06 alone sets them.
+*/
+static uint16_t nrpn = 0x3FFF;	/* the parameter selected, 0x3FFF for none */
+static uint16_t nrpn_value = 0;
+
+static void OnNonRegisteredParameter(uint16_t param, uint16_t value) {
+  switch (param) {
+#if FINGERING_ENABLED
+  case NPRN_NOTE: scale_set(value >> 7, Fingering::get_scale_type()); return;
+  case NPRN_SCALE: scale_set(Fingering::get_root_note(), value >> 7); return;
+#endif
+#if TOUCHPADS_ENABLED
+  case NPRN_THRESHOLD: TouchPads::set_threshold(value >> 7); return;
+  case NPRN_STEPS: TouchPads::set_steps(value >> 7); return;
+#endif
+  case NPRN_EURO_MIN_CUTOFF: pressure_euro.minCutoff(value / 100.0f); return;
+  case NPRN_EURO_BETA: pressure_euro.beta(value / 100.0f); return;
+  case NPRN_EURO_D_CUTOFF: pressure_euro.derivativeCutoff(value / 100.0f); return;
+  case NPRN_TONGUE_DEPTH: Articulation::depth(value / 1000.0f); return;
+  case NPRN_TONGUE_SLOPE: Articulation::slope(value / 100.0f); return;
+  case NPRN_TONGUE_RECOVER: Articulation::recover(value / 1000.0f); return;
+  case NPRN_OVERBLOW_UP: Overblow::up(value / 1000.0f); return;
+  case NPRN_OVERBLOW_DOWN: Overblow::down(value / 1000.0f); return;
+  case NPRN_BEND_CENTER: BreathBend::center(value / 1000.0f); return;
+  case NPRN_BEND_DEPTH: BreathBend::depth(value / 100.0f); return;
+  case NPRN_BEND_RANGE: BreathBend::range(value >> 7); return;
+  case NPRN_BEND_INTERVAL: BreathBend::interval(value); return;
+  case NPRN_VELOCITY_WINDOW: Velocity::window(value >> 7); return;
+  case NPRN_VELOCITY_CAP: Velocity::cap(value >> 7); return;
+  case NPRN_VELOCITY_FULL: Velocity::full(value / 10.0f); return;
+  case NPRN_TUNING: Midi::tuning(value / 10.0f); Tuning::refresh(); return;
+  }
+}
+
 static void OnControlChange(byte channel, byte control, byte value) {
   Serial.print("rcvd ctl chg "); Serial.print(control); Serial.print(" "); Serial.println(value);
   switch (control) {
+  case 0x63: /* control change: non-registered parameter number, msb */
+    nrpn = (nrpn & 0x7F) | (value << 7); return;
+  case 0x62: /* control change: non-registered parameter number, lsb */
+    nrpn = (nrpn & 0x3F80) | value; return;
+  case 0x06: /* control change: data entry msb, the lsb is cleared */
+    nrpn_value = value << 7;
+    OnNonRegisteredParameter(nrpn, nrpn_value); return;
+  case 0x26: /* control change: data entry lsb */
+    nrpn_value = (nrpn_value & 0x3F80) | value;
+    OnNonRegisteredParameter(nrpn, nrpn_value); return;
 #if FINGERING_ENABLED
   case 0x10: /* control change: set base note for fingering */
-    Fingering::set_scale(value, Fingering::get_scale_type()); return;
+    scale_set(value, Fingering::get_scale_type()); return;
   case 0x11: /* control change: set scale type for fingering */
-    Fingering::set_scale(Fingering::get_root_note(), value); return;
+    scale_set(Fingering::get_root_note(), value); return;
 #endif
 #if TOUCHPADS_ENABLED
   case 0x12: /* control change: set threshold for normalized touch */
@@ -112,6 +310,26 @@ static void OnControlChange(byte channel, byte control, byte value) {
     TouchPads::set_steps(value); return;
   case 0x14: /* control change: reset ranges */
     TouchPads::reset(); return;
+  case 0x19: /* control change: select pad for filter settings, >= NPADS for all */
+    filter_pad = value; return;
+  case 0x1A: /* control change: median of 3 spike filter on/off */
+    if (filter_pad < NPADS) TouchPads::set_filter_median(value, filter_pad);
+    else TouchPads::set_filter_median(value);
+    return;
+  case 0x1B: /* control change: filter type, 0 none, 1 one pole, 2 biquad */
+    if (filter_pad < NPADS) TouchPads::set_filter_type(value, filter_pad);
+    else TouchPads::set_filter_type(value);
+    return;
+  case 0x1C: /* control change: filter cutoff, value/256 of scan rate */
+    if (filter_pad < NPADS) TouchPads::set_filter_cutoff(value, filter_pad);
+    else TouchPads::set_filter_cutoff(value);
+    return;
+  case 0x1D: /* control change: biquad Q, value/16 */
+    if (filter_pad < NPADS) TouchPads::set_filter_q(value, filter_pad);
+    else TouchPads::set_filter_q(value);
+    return;
+  case 0x1E: /* control change: debounce time in milliseconds, needs fixed rate scanning */
+    TouchPads::set_debounce_ms(value); return;
 #endif
   case 0x15: /* control change: hardware averaging */
     return;
@@ -121,6 +339,20 @@ static void OnControlChange(byte channel, byte control, byte value) {
     return;
   case 0x18: /* control change: prescale */
     return;
+  case 0x55: /* control change: breath curve dead zone, value/127 */
+    BreathCurve::shape(value / 127.0f, BreathCurve::_gamma, BreathCurve::_sat); return;
+  case 0x56: /* control change: breath curve gamma, value/16 */
+    BreathCurve::shape(BreathCurve::_dead, value / 16.0f, BreathCurve::_sat); return;
+  case 0x57: /* control change: breath curve saturation, value/127 */
+    BreathCurve::shape(BreathCurve::_dead, BreathCurve::_gamma, value / 127.0f); return;
+#if SYNTH_ENABLED
+  case 0x07: /* control change: channel volume, the output level */
+    amp2.gain(AUDIO_OUT_GAIN * value * value / (127.0f * 127.0f)); return;
+  case 0x7A: /* control change: local control, onboard synth on/off */
+    local_control = value >= 64;
+    if ( ! local_control) synth_set_note(micros(), 0xFF);
+    return;
+#endif
   }
 }
 
@@ -129,21 +361,45 @@ static void OnControlChange(byte channel, byte control, byte value) {
 ** Program Change has to do with the standard synth voices
 ** But could be overloaded to switch in different voices
 */
+/*
+** System exclusive, see Config.h, the whole message from F0 to F7
+*/
+static void OnSystemExclusive(byte *data, unsigned size) {
+  if (size < 4 || data[1] != SYSEX_ID) return;
+  switch (data[2]) {
+  case SYSEX_BREATH_CURVE: /* F0 7D 01 x0 y0 x1 y1 ... F7 */
+    if ( ! BreathCurve::points(data + 3, size - 4)) Serial.println("bad breath curve");
+    return;
+  case SYSEX_BEND_DEGREES: /* F0 7D 02 c0 c1 c2 ... F7 */
+    if ( ! BreathBend::degrees(data + 3, size - 4)) Serial.println("bad bend degrees");
+    return;
+  case SYSEX_TUNING: /* F0 7D 03 k0 s0 m0 l0 k1 s1 m1 l1 ... F7 */
+    if ( ! Tuning::retune(data + 3, size - 4)) Serial.println("bad tuning");
+    return;
+  }
+}
+
 static void OnProgramChange(byte channel, byte program) {
   Serial.print("rcvd pgm chg "); Serial.println(program);
+#if SYNTH_ENABLED
+  synth_set_voice(program);
+#endif
 }
 #endif // MIDI_INPUT_ENABLED
 
 void setup() { 
   Monitor::begin();
+  Midi::tuning(TUNING_A4);
+  Tuning::begin();
   Monitor::message("initialize Audio memory\n");
-  AudioMemory(12);
+  AudioMemory(16);
 #if MIDI_INPUT_ENABLED
   Monitor::message("initialize USB handlers\n");
   usbMIDI.setHandleNoteOff(OnNoteOff);
   usbMIDI.setHandleNoteOn(OnNoteOn);
   usbMIDI.setHandleControlChange(OnControlChange);
   usbMIDI.setHandleProgramChange(OnProgramChange);
+  usbMIDI.setHandleSystemExclusive(OnSystemExclusive);
 #endif
 #if TOUCHPADS_ENABLED
   Monitor::message("initialize touch pads\n");
@@ -158,11 +414,44 @@ void setup() {
   Pressure::begin();
 #endif
   Monitor::message("initialize audio input\n");
-  AudioIn::begin();
-  amp1.gain(1.00000);
+  AudioIn::begin(breath1);
+  AudioIn::begin(cond1);
+  BreathCurve::begin();
+  Articulation::begin();
+  Overblow::begin();
+  BreathBend::begin();
+  Velocity::begin();
+  pressure_euro.minCutoff(BREATH_EURO_MIN_CUTOFF);
+  pressure_euro.beta(BREATH_EURO_BETA);
+  pressure_euro.derivativeCutoff(BREATH_EURO_D_CUTOFF);
   Monitor::message("initialize audio output\n");
   AudioOut::begin();
-  amp2.gain(0.03125);
+  mix2.gain(0, 1.0);
+  mix2.gain(1, 1.0);
+#if SYNTH_ENABLED
+  wave1.begin(0.0, 440.0, WAVEFORM_SAWTOOTH);
+  filt1.resonance(1.0);
+  amp3.gain(0.0);
+#endif
+  amp2.gain(AUDIO_OUT_GAIN);
+#if AUDIO_PROFILE_ENABLED
+  profile1.add(i2s1, "i2s1");
+  profile1.add(usb2, "usb2");
+#if SYNTH_ENABLED
+  profile1.add(flute1, "flute1");
+  profile1.add(wave1, "wave1");
+  profile1.add(filt1, "filt1");
+  profile1.add(amp3, "amp3");
+  profile1.add(voice1, "voice1");
+#endif
+  profile1.add(cond1, "cond1");
+  profile1.add(breath1, "breath1");
+  profile1.add(pitch1, "pitch1");
+  profile1.add(mix2, "mix2");
+  profile1.add(amp2, "amp2");
+  profile1.add(usb1, "usb1");
+  profile1.add(i2s2, "i2s2");
+#endif
   Monitor::message("setup finished\n");
 }
 
@@ -171,38 +460,209 @@ static uint32_t last_touch_clock = 0;
 #endif
 
 #if PRESSURE_ENABLED
-static uint16_t last_pressure = 0;
-static uint16_t pressure = 0;
+static uint32_t last_pressure = 0;	/* Pa, a new value marks a finished conversion */
+static uint32_t pressure = 0;
 #endif
 
 #if FINGERING_ENABLED
 static uint8_t channel = 1;
 static uint8_t last_note = 0xFF;
 static uint8_t note = 0xFF;
+
+/*
+** The note sounding, on MIDI and the onboard voice, 0xFF for none.
+** It is the fingered note, unless the breath is stopped, see
+** Articulation.h, so a tongued repeat of the same note retriggers.
+** A note started from silence sounds at once on the onboard voice,
+** but its NoteOn waits, a few milliseconds at most, for a velocity
+** from the breath's rise, see Velocity.h.
+*/
+static uint8_t sounding = 0xFF;
+
+/*
+** The MIDI note the last NoteOn went out on, 0xFF for none, so the
+** NoteOff goes to that note even if a tuning change since has moved
+** Tuning::note() of the note sounding.
+*/
+static uint8_t sent_note = 0xFF;
+
+/*
+** The breath's pitch bend of the note sounding, see BreathBend.h,
+** and its tuning, see Tuning.h, to MIDI no more often than the bend
+** interval, but always just before a NoteOn, and to the onboard
+** voice at once, a new note taking it with its frequency.
+*/
+enum { BEND_HELD, BEND_MIDI, BEND_LOCAL };	/* a held note, or the onset of one */
+static float breath_level = 0;
+static uint16_t bend_local = 8192;
+static void bend(uint32_t stamp, uint8_t onset) {
+  float cents = 0;
+#if BEND_ENABLED
+  cents = BreathBend::cents(sounding, breath_level);
+#endif
+  // MIDI bends the note by the key's tuning too, the onboard voice tunes the key
+  uint16_t value = BreathBend::bend(cents + Tuning::cents(sounding));
+  if (onset != BEND_LOCAL && BreathBend::due(value, stamp, onset == BEND_MIDI))
+    usbMIDI.sendPitchBend(value - 8192, channel);
+#if SYNTH_ENABLED
+  if (onset == BEND_LOCAL) synth_cents = cents;
+  else if (onset == BEND_HELD && value != bend_local) synth_set_bend(stamp, cents);
+  else return;
+  bend_local = value;
+#endif
+}
+
+static void note_on(uint32_t stamp, uint8_t velocity) {
+  bend(stamp, BEND_MIDI);
+  sent_note = Tuning::note(sounding);
+  usbMIDI.sendNoteOn(sent_note, velocity, channel);
+  usbMIDI.send_now();
+}
+
+static void note_off() {
+  if (sent_note != 0xFF) usbMIDI.sendNoteOff(sent_note, 0, channel);
+  sent_note = 0xFF;
+}
+
+static void sound(uint32_t stamp, uint8_t new_note) {
+  if (new_note == sounding) return;
+#if VELOCITY_ENABLED
+  uint8_t old_note = sounding;
+#endif
+  sounding = new_note;
+#if VELOCITY_ENABLED
+  if (Velocity::pending()) {
+    // the old note's NoteOn never went out, the new one waits in its place
+    if (new_note == 0xFF) Velocity::cancel();
+  } else {
+    note_off();
+    if (new_note == 0xFF) usbMIDI.send_now();
+    else if (old_note == 0xFF) Velocity::start(stamp, micros());
+    else note_on(stamp, Velocity::velocity());
+  }
+#else
+  note_off();
+  if (new_note != 0xFF) note_on(stamp, 127);
+  else usbMIDI.send_now();
+#endif
+#if SYNTH_ENABLED
+  if (new_note != 0xFF) bend(stamp, BEND_LOCAL);
+  synth_set_note(stamp, local_control ? new_note : 0xFF);
+#endif
+}
+static uint8_t fingered_sound() {
+#if ARTICULATION_ENABLED
+  if (Articulation::stopped()) return 0xFF;
+#endif
+  return note;
+}
+/*
+** The fingered note from the pads' last touch, in the register
+** last chosen, true if it changed.
+*/
+static bool finger() {
+  uint8_t new_note = Fingering::translate(TouchPads::last_touch());
+  if (new_note == note) return false;
+  last_note = note; note = new_note;
+  Monitor::note_stream();
+  return true;
+}
+/*
+** The fingering's root note and scale type, and the breath bends
+** for them, the note fingered now moves to the new scale at once.
+*/
+static void scale_set(uint8_t root, uint8_t type) {
+  Fingering::set_scale(root, type);
+#if BEND_ENABLED
+  BreathBend::scale(root, type);
+#endif
+  if (finger()) sound(micros(), fingered_sound());
+}
 #endif
 
+/*
+** The fused breath level through the breath curve to the breath
+** controller, when its 7 bits change, and to the onboard voice,
+** and through the overblow register and the articulation detector
+** to the note.  Both are settled before the note is sounded, so a
+** change of register, or a stop at the end of an overblown breath,
+** never sounds the wrong octave on the way.  Then the note sounding
+** is bent with the breath.  Only the mic's updates go to the
+** articulation detector, whose stamps must run in order and whose
+** slope is tuned to the mic's 2.9ms steps.
+*/
+static uint8_t breath_cc = 0xFF;
+static void breath_set(uint32_t stamp, float level, bool mic) {
+  int32_t expression = BreathCurve::map((int32_t)(level * 32767.0f));
+#if FINGERING_ENABLED
+  uint8_t cc = expression >> 8;
+  if (cc != breath_cc) {
+    breath_cc = cc;
+    usbMIDI.sendControlChange(0x02, cc, channel);
+  }
+#endif
+#if SYNTH_ENABLED
+  synth_set_breath(stamp, expression / 32767.0f);
+#endif
+#if FINGERING_ENABLED
+  bool moved = false;
+  breath_level = level;
+#if VELOCITY_ENABLED
+  uint8_t velocity = Velocity::sample(level, stamp, micros());
+  if (velocity) note_on(stamp, velocity);
+#endif
+#if OVERBLOW_ENABLED && (NPADS == 6 || NPADS == 7)
+  if (Overblow::update(level)) {
+    Fingering::set_register(Overblow::octave());
+    moved = finger();
+  }
+#endif
+#if ARTICULATION_ENABLED
+  if (mic && Articulation::update(level, stamp) != Articulation::NONE) moved = true;
+#endif
+  if (moved) sound(stamp, fingered_sound());
+  if (sounding != 0xFF) bend(stamp, BEND_HELD);
+#endif
+}
+
 void loop() {
   Monitor::update(); 
 
+#if SYNTH_ENABLED
+  synth_poll();
+#endif
+
+#if FINGERING_ENABLED && VELOCITY_ENABLED
+  // a NoteOn waiting for its velocity goes out by the cap
+  if (Velocity::pending()) {
+    uint8_t velocity = Velocity::poll(micros());
+    if (velocity) note_on(micros(), velocity);
+  }
+#endif
+
   if (TouchPads::clock() != last_touch_clock) {
     last_touch_clock = TouchPads::clock();
     Monitor::touch_stream();
   }
+  // breath from the mic envelope and the barometer, see BreathFusion.h
+  if (breath1.available()) {
+    BreathFusion::mic(breath1.read(), breath1.stamp());
+    Monitor::breath_stream();
+    breath_set(BreathFusion::stamp(), BreathFusion::level(), true);
+  }
+  if (pitch1.available()) Monitor::pitch_stream();
+  uint32_t pressure_stamp = micros();
   uint32_t new_pressure = Pressure::readPressure();
   if (new_pressure != pressure) {
     last_pressure = pressure; pressure = new_pressure;
+    if (BreathFusion::micIdle()) Pressure::follow();
+    BreathFusion::baro(pressure_euro.filter(Pressure::lastBreathLevel(), pressure_stamp), pressure_stamp);
     Monitor::pressure_stream();
-    // translate pressure into AfterTouch and send
+    breath_set(BreathFusion::stamp(), BreathFusion::level(), false);
   }
-  if (TouchPads::available()) {
-    uint8_t new_note = Fingering::translate(TouchPads::last_touch());
-    if (new_note != note) {
-      last_note = note; note = new_note;
-      Monitor::note_stream();
-      if (last_note != 0xFF) usbMIDI.sendNoteOff(last_note, 0, channel);
-      if (note != 0xFF) usbMIDI.sendNoteOn(note, 127, channel);
-      usbMIDI.send_now();
-    }
+  if (TouchPads::available() && finger()) {
+    // at the time the pads were scanned
+    sound(TouchPads::stamp(), fingered_sound());
   }
   usbMIDI.read(channel);
 }
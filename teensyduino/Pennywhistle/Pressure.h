@@ -207,6 +207,27 @@ namespace Pressure {
     return last_p = (p+128)>>8;
   }
   uint32_t lastPressure(void) { return last_p; }
+
+  /*
+  ** Breath is the pressure above ambient, the ambient
+  ** pressure is taken from the first reading, then follows
+  ** the readings taken while nobody blows, so a first reading
+  ** taken mid breath and the weather's drift both wash out.
+  */
+  static int32_t ambient_q8;		/* Pa, Q8 */
+  int32_t lastBreath(void) {
+    if (ambient_q8 == 0) ambient_q8 = last_p << 8;
+    return (int32_t)last_p - (ambient_q8 >> 8);
+  }
+  /* the last reading was ambient, follow it over 2^BREATH_AMBIENT_SHIFT readings */
+  void follow(void) {
+    if (ambient_q8 == 0) ambient_q8 = last_p << 8;
+    ambient_q8 += ((int32_t)(last_p << 8) - ambient_q8) >> BREATH_AMBIENT_SHIFT;
+  }
+  /* breath scaled to 0..1 by BREATH_FULL_SCALE */
+  float lastBreathLevel(void) {
+    return constrain((float)lastBreath() / BREATH_FULL_SCALE, 0.0f, 1.0f);
+  }
   
   static int begin() {
     Serial.println("setting SDA to 34");
@@ -0,0 +1,111 @@
+/* -*- mode: c++; tab-width: 8 -*- */
+/*
+  Copyright (C) 2018 by Roger E Critchlow Jr, Charlestown, MA, USA.
+
+  This program is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation; either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program; if not, write to the Free Software
+  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307 USA
+*/
+/*
+** Timestamped control events from loop() to a local voice.
+**
+** loop() posts note and breath changes stamped with the micros()
+** at which the touch scan or pressure reading was acquired.  The
+** voice drains the queue in its update(), which runs in the audio
+** interrupt, and applies each event at the sample offset inside
+** the block that matches its stamp.
+**
+** The block being computed covers the block_micros before the
+** update, so every event arrives exactly one block late and the
+** spacing between events is kept to the sample, instead of being
+** rounded to block boundaries.  Events stamped before that window
+** are applied at offset 0 and counted as late, those stamped after
+** it wait for a later block.
+**
+** The queue has a single writer, loop(), and a single reader, the
+** audio interrupt, so the head and tail indexes need no locking.
+*/
+#ifndef SynthEvents_h
+#define SynthEvents_h
+
+#include <AudioStream.h>
+
+class SynthEvents
+{
+ public:
+  static const uint8_t NOTE_ON = 1;	/* value is frequency in Hz */
+  static const uint8_t NOTE_OFF = 2;
+  static const uint8_t BREATH = 3;	/* value is breath level 0 to 1 */
+  static const uint8_t FREQUENCY = 4;	/* value is frequency in Hz, without a new note */
+
+  struct event {
+    uint32_t stamp;			/* micros() at acquisition */
+    uint8_t type;
+    float value;
+  };
+
+  SynthEvents() : _head(0), _tail(0), _late(0), _dropped(0) { }
+
+  /* from loop(), false if the queue is full */
+  bool post(uint32_t stamp, uint8_t type, float value = 0.0f) {
+    uint8_t head = _head;
+    if ((uint8_t)(head - _tail) >= SIZE) {
+      _dropped += 1;
+      return false;
+    }
+    event &e = _events[head & (SIZE-1)];
+    e.stamp = stamp;
+    e.type = type;
+    e.value = value;
+    /* the event must be written before the audio interrupt can see it */
+    __asm__ volatile("" ::: "memory");
+    _head = head + 1;
+    return true;
+  }
+
+  /* from update(), the start of the block being computed */
+  static uint32_t block_start(uint32_t now) { return now - block_micros; }
+
+  /* from update(), the sample offset of the next event, AUDIO_BLOCK_SAMPLES if none is due in this block */
+  int next_offset(uint32_t start) {
+    if (_tail == _head) return AUDIO_BLOCK_SAMPLES;
+    int32_t us = _events[_tail & (SIZE-1)].stamp - start;
+    if (us < 0) return 0;
+    if (us >= (int32_t)block_micros) return AUDIO_BLOCK_SAMPLES;
+    // samples per microsecond in Q16
+    int32_t offset = (us * 2891) >> 16;
+    return offset < AUDIO_BLOCK_SAMPLES ? offset : AUDIO_BLOCK_SAMPLES-1;
+  }
+
+  /* from update(), take the next event, after next_offset() says it is due */
+  event pop(uint32_t start) {
+    event e = _events[_tail & (SIZE-1)];
+    if ((int32_t)(e.stamp - start) < 0) _late += 1;
+    _tail += 1;
+    return e;
+  }
+
+  bool empty() { return _tail == _head; }
+  uint32_t late() { return _late; }
+  uint32_t dropped() { return _dropped; }
+
+ private:
+  static const uint8_t SIZE = 16;	/* power of 2 */
+  static const uint32_t block_micros = (uint32_t)(AUDIO_BLOCK_SAMPLES * 1000000.0f / AUDIO_SAMPLE_RATE_EXACT + 0.5f);
+
+  event _events[SIZE];
+  volatile uint8_t _head, _tail;
+  uint32_t _late, _dropped;
+};
+
+#endif // SynthEvents_h
@@ -23,6 +23,7 @@
 #include "Teensy3Touch.h"
 
 uint32_t Teensy3Touch::_clock;
+uint32_t Teensy3Touch::_scanMicros;
 uint16_t Teensy3Touch::_value[16];
 uint8_t Teensy3Touch::_active[16];
 uint8_t Teensy3Touch::_nactive;
@@ -30,6 +31,28 @@ uint8_t Teensy3Touch::_pactive;
 uint8_t Teensy3Touch::_cactive;
 uint8_t Teensy3Touch::_scanning;
 void (*Teensy3Touch::_callback)(uint16_t *);
+uint32_t Teensy3Touch::_gencs;
+uint32_t Teensy3Touch::_period;
+volatile uint8_t Teensy3Touch::_busy;
+uint32_t Teensy3Touch::_overruns;
+IntervalTimer Teensy3Touch::_timer;
+#if defined(HAS_KINETIS_TSI_LITE)
+uint8_t Teensy3Touch::_nslot;
+uint8_t Teensy3Touch::_idleEvery;
+uint8_t Teensy3Touch::_slot;
+uint8_t Teensy3Touch::_phot;
+uint8_t Teensy3Touch::_nhot;
+uint8_t Teensy3Touch::_hotHold;
+uint16_t Teensy3Touch::_hotDelta;
+uint8_t Teensy3Touch::_hot[16];
+#endif
+#if defined(HAS_KINETIS_TSI)
+uint32_t Teensy3Touch::_slots[Teensy3Touch::nslots][8];
+uint8_t Teensy3Touch::_batching;
+uint8_t Teensy3Touch::_pit;
+DMAChannel Teensy3Touch::_dmaCounts(false);
+DMAChannel Teensy3Touch::_dmaTrigger(false);
+#endif
 
 #if defined(HAS_KINETIS_TSI) || defined(HAS_KINETIS_TSI_LITE)
 
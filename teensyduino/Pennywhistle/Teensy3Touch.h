@@ -22,11 +22,42 @@
 ** Scanning proceeds continuously in the background.
 ** Optional callback from background to provide values at end of each scan.
 ** Or poll the clock() to determine end of scan.
+**
+** On Teensy 3.x startBatch() scans without any interrupt per scan.
+** The TSI can't request DMA at end of scan, so a PIT channel paces
+** a DMA channel instead: at each tick it copies the counters from
+** the scan started at the previous tick into a ring of slots, then
+** a linked DMA channel writes TSI0_GENCS to start the next scan.
+** The CPU is interrupted once per half ring, when the callback runs
+** for each of the scans in that half.  The period must be longer
+** than one scan of all the electrodes.  The PIT channel is only
+** taken when it is idle, so an IntervalTimer already running on it
+** makes startBatch() fail, and while it runs IntervalTimer skips it.
+** scanMicros() gives the time each scan in the half was copied,
+** reckoned back from the interrupt by whole periods.
+**
+** startPeriodic() scans at a fixed rate set by an IntervalTimer
+** rather than restarting from the end of scan interrupt, so the
+** scan period is exact and the same on every board.  A tick which
+** arrives before the previous scan finished is counted as an overrun
+** and skipped.
+**
+** On Teensy LC, which measures one electrode per interrupt,
+** setAdaptive() lets the electrodes that are changing take the
+** slots of the idle ones.  A channel turns hot when its count moves
+** by more than hotDelta between visits, or when setHot() says so,
+** and stays hot for hotHold visits.  Every idleEvery'th slot still
+** goes round robin, so each electrode is measured at least once in
+** every idleEvery*nactive slots.  A scan, for clock() and the
+** callback, is nactive slots whichever electrodes were measured.
 */
 #ifndef Teensy3Touch_h
 #define Teensy3Touch_h
 
 #include "WProgram.h"
+#if defined(HAS_KINETIS_TSI)
+#include "DMAChannel.h"
+#endif
 
 class Teensy3Touch
 {
@@ -48,6 +79,7 @@ class Teensy3Touch
 
   /* data */
   static uint32_t _clock;		/* interrupt counter */
+  static uint32_t _scanMicros;		/* time of the scan passed to the callback */
   static uint16_t _value[16];		/* channel value */
   static uint16_t _error;		/* electrode/overflow/outofrange error status */
   static uint32_t _scanc;		/* precomputed _scanc register */
@@ -58,6 +90,28 @@ class Teensy3Touch
   static uint8_t _cactive;		/* currently scanning electrode channel */
   static uint8_t _scanning;		/* scanning is in progress */
   static void (*_callback)(uint16_t *);	/* callback at end of scan */
+  static uint32_t _period;		/* fixed scan period in microseconds, 0 if free running */
+  static volatile uint8_t _busy;	/* fixed rate scan in progress */
+  static uint32_t _overruns;		/* fixed rate ticks skipped while busy */
+  static IntervalTimer _timer;		/* fixed rate scan trigger */
+#if defined(HAS_KINETIS_TSI_LITE)
+  static uint8_t _nslot;		/* slots measured in this scan */
+  static uint8_t _idleEvery;		/* adaptive, every idleEvery'th slot is round robin, 0 for off */
+  static uint8_t _slot;			/* adaptive, slot counter */
+  static uint8_t _phot;			/* adaptive, last hot element of _active measured */
+  static uint8_t _nhot;			/* adaptive, number of hot channels */
+  static uint8_t _hotHold;		/* adaptive, visits a channel stays hot */
+  static uint16_t _hotDelta;		/* adaptive, count change that makes a channel hot */
+  static uint8_t _hot[16];		/* adaptive, visits left hot per channel */
+#endif
+#if defined(HAS_KINETIS_TSI)
+  static const int nslots = 16;		/* scans in the batch ring, two halves */
+  static uint32_t _slots[nslots][8];	/* TSI0_CNTR1..TSI0_CNTR15 for each scan */
+  static uint8_t _batching;		/* scanning by DMA */
+  static uint8_t _pit;			/* PIT channel pacing the DMA */
+  static DMAChannel _dmaCounts;		/* copies the counters */
+  static DMAChannel _dmaTrigger;	/* restarts the scan */
+#endif
 
 #if defined(__MK20DX128__) || defined(__MK20DX256__)
   // Teensy 3.0, 3.1, and 3.2
@@ -103,6 +157,12 @@ class Teensy3Touch
   static bool scanning() { return _scanning; }
   /* get the clock */
   static uint32_t clock() { return _clock; }
+  /* get the micros() time of the scan the callback is being given */
+  static uint32_t scanMicros() { return _scanMicros; }
+  /* get the fixed scan period in microseconds, 0 if free running */
+  static uint32_t period() { return _period; }
+  /* get the count of fixed rate ticks skipped */
+  static uint32_t overruns() { return _overruns; }
   /* start scanning */
   static uint16_t start(uint16_t mask,
 			uint8_t refchrg = 3, uint8_t extchrg = 2, uint8_t nscan = 9, uint8_t prescale = 2, 
@@ -140,6 +200,9 @@ class Teensy3Touch
     /* start the scan */
     _pactive = 0;
     _cactive = _active[_pactive];
+#if defined(HAS_KINETIS_TSI_LITE)
+    _nslot = 0;
+#endif
 #if defined(HAS_KINETIS_TSI)
     /* set selected channel mask, trigger scan */
     TSI0_PEN = mask;
@@ -161,15 +224,182 @@ class Teensy3Touch
     TSI0_DATA |= TSI_DATA_SWTS;
 #endif
     /* tag as scanning */
+    _busy = 1;
     _scanning = 1;
     return mask;
   }
 
+#if defined(HAS_KINETIS_TSI_LITE)
+  /* measure changing electrodes more often, idleEvery 0 for plain round robin */
+  static void setAdaptive(uint8_t idleEvery, uint16_t hotDelta = 16, uint8_t hotHold = 32) {
+    __disable_irq();
+    _idleEvery = idleEvery < 2 ? 0 : idleEvery;
+    _hotDelta = hotDelta;
+    _hotHold = hotHold;
+    for (int i = 0; i < nchannels; i += 1) _hot[i] = 0;
+    _nhot = 0;
+    __enable_irq();
+  }
+  /* mark a channel as hot, eg when its touch is near threshold */
+  static void setHot(uint8_t channel) {
+    if (_idleEvery == 0) return;
+    __disable_irq();
+    if (_hot[channel] == 0) _nhot += 1;
+    _hot[channel] = _hotHold;
+    __enable_irq();
+  }
+#endif
+
+  /* start scanning once every period_us microseconds */
+  static uint16_t startPeriodic(uint16_t mask, uint32_t period_us,
+				uint8_t refchrg = 3, uint8_t extchrg = 2, uint8_t nscan = 9, uint8_t prescale = 2, 
+				void (*callback)(uint16_t *) = NULL) {
+    if (_scanning) stop();
+    /* set before the first scan so touchISR() doesn't retrigger */
+    _period = period_us;
+    _overruns = 0;
+    if (start(mask, refchrg, extchrg, nscan, prescale, callback) == 0 ||
+	! _timer.begin(timerISR, period_us)) {
+      stop();
+      _period = 0;
+      return 0;
+    }
+    return mask;
+  }
+
+  /* Start a fixed rate scan */
+  static void timerISR() {
+    if (_busy) {
+      _overruns += 1;
+      return;
+    }
+    _busy = 1;
+#if defined(HAS_KINETIS_TSI)
+    TSI0_GENCS |= TSI_GENCS_SWTS;
+#elif defined(HAS_KINETIS_TSI_LITE)
+    TSI0_DATA = TSI_DATA_TSICH(_cactive) | TSI_DATA_SWTS;
+#endif
+  }
+
+#if defined(HAS_KINETIS_TSI)
+  /* start scanning in batches every period_us microseconds */
+  static uint16_t startBatch(uint16_t mask, uint32_t period_us,
+			     uint8_t refchrg = 3, uint8_t extchrg = 2, uint8_t nscan = 9, uint8_t prescale = 2, 
+			     void (*callback)(uint16_t *) = NULL) {
+    if (_scanning) stop();
+    _nactive = 0;
+    if (mask == 0 || ! validChannels(mask))
+      return 0;
+    for (int i = 0; i < nchannels; i += 1) {
+      if ( ! (mask & (1<<i)) ) continue;
+      *portConfigRegister(channelPin(i)) = PORT_PCR_MUX(0);
+      _active[_nactive++] = i;
+      _value[i] = 0;
+    }
+    _dmaCounts.begin();
+    _dmaTrigger.begin();
+    /* periodic triggering only exists on DMA channels 0-3, paired with PIT 0-3 */
+    _pit = _dmaCounts.channel;
+    if (_pit > 3) {
+      _dmaCounts.release();
+      _dmaTrigger.release();
+      _nactive = 0;
+      return 0;
+    }
+    /* IntervalTimer may already own the PIT, it takes only idle channels */
+    SIM_SCGC6 |= SIM_SCGC6_PIT;
+    volatile uint32_t *pit = &PIT_LDVAL0 + 4*_pit; /* LDVAL, CVAL, TCTRL, TFLG */
+    if (pit[2] & PIT_TCTRL_TEN) {
+      _dmaCounts.release();
+      _dmaTrigger.release();
+      _nactive = 0;
+      return 0;
+    }
+    _callback = callback;
+    /* configure the TSI, but leave its interrupt off */
+    SIM_SCGC5 |= SIM_SCGC5_TSI;
+    TSI0_GENCS = 0;
+    TSI0_PEN = mask;
+    TSI0_SCANC = TSI_SCANC_REFCHRG(refchrg) | TSI_SCANC_EXTCHRG(extchrg);
+    TSI0_GENCS = TSI_GENCS_NSCN(nscan) | TSI_GENCS_PS(prescale) | TSI_GENCS_TSIEN;
+    /* the value the trigger channel writes, clears eosf and starts a scan */
+    _gencs = TSI0_GENCS | TSI_GENCS_EOSF | TSI_GENCS_SWTS;
+    /* counters, 8 words per tick, into the ring of slots */
+    _dmaCounts.TCD->SADDR = &TSI0_CNTR1;
+    _dmaCounts.TCD->SOFF = 4;
+    _dmaCounts.TCD->ATTR = DMA_TCD_ATTR_SSIZE(2) | DMA_TCD_ATTR_DSIZE(2);
+    _dmaCounts.TCD->NBYTES_MLNO = sizeof(_slots[0]);
+    _dmaCounts.TCD->SLAST = -(int32_t)sizeof(_slots[0]);
+    _dmaCounts.TCD->DADDR = _slots;
+    _dmaCounts.TCD->DOFF = 4;
+    _dmaCounts.TCD->CITER_ELINKNO = nslots;
+    _dmaCounts.TCD->DLASTSGA = -(int32_t)sizeof(_slots);
+    _dmaCounts.TCD->BITER_ELINKNO = nslots;
+    _dmaCounts.TCD->CSR = 0;
+    _dmaCounts.interruptAtHalf();
+    _dmaCounts.interruptAtCompletion();
+    _dmaCounts.attachInterrupt(batchISR);
+    /* restart the scan after each copy, the last minor loop links through major completion */
+    _dmaTrigger.source(_gencs);
+    _dmaTrigger.destination(TSI0_GENCS);
+    _dmaTrigger.transferSize(4);
+    _dmaTrigger.transferCount(1);
+    _dmaTrigger.triggerAtTransfersOf(_dmaCounts);
+    _dmaTrigger.triggerAtCompletionOf(_dmaCounts);
+    _dmaTrigger.enable();
+    _period = period_us;
+    /* PIT ticks trigger the counter copies */
+    volatile uint8_t *mux = &DMAMUX0_CHCFG0 + _dmaCounts.channel;
+    *mux = 0;
+    *mux = DMAMUX_SOURCE_ALWAYS0 | DMAMUX_TRIG | DMAMUX_ENABLE;
+    _dmaCounts.enable();
+    PIT_MCR = 0;
+    pit[0] = (uint64_t)F_BUS * period_us / 1000000 - 1;
+    pit[2] = PIT_TCTRL_TEN;
+    /* first scan */
+    TSI0_GENCS = _gencs;
+    _batching = 1;
+    _scanning = 1;
+    return mask;
+  }
+
+  /* Process a completed half of the batch ring */
+  static void batchISR() {
+    _dmaCounts.clearInterrupt();
+    /* the DMA is writing the other half */
+    int first = ((uint32_t *)_dmaCounts.TCD->DADDR < _slots[nslots/2]) ? nslots/2 : 0;
+    /* the last slot of the half was copied at the tick that raised this interrupt */
+    uint32_t now = micros();
+    for (int s = first; s < first+nslots/2; s += 1) {
+      _scanMicros = now - (first+nslots/2-1-s) * _period;
+      const uint16_t *counts = (const uint16_t *)_slots[s];
+      for (int i = 0; i < _nactive; i += 1) {
+	int j = _active[i];
+	_value[j] = counts[j];
+      }
+      _clock += 1;
+      if (_callback != NULL) _callback(_value);
+    }
+  }
+#endif
+
   /* stop scanning */
   static void stop() {
     if ( ! _scanning) return;
     /* clear the scanning flag */
     _scanning = 0;
+    if (_period != 0) {
+      _timer.end();
+      _period = 0;
+    }
+#if defined(HAS_KINETIS_TSI)
+    if (_batching) {
+      _batching = 0;
+      (&PIT_LDVAL0)[4*_pit+2] = 0;
+      _dmaCounts.disable();
+      _dmaTrigger.disable();
+    }
+#endif
     /* disable TSI */
     TSI0_GENCS = 0;
     /* disable interrupt */
@@ -188,27 +418,73 @@ class Teensy3Touch
       int j = _active[i];
       _value[j] = *((volatile uint16_t *)(&TSI0_CNTR1) + j);
     }
+    _scanMicros = micros();
     if (_callback != NULL) _callback(_value);
-    // clear eosf and trigger scan
-    TSI0_GENCS |= TSI_GENCS_EOSF | TSI_GENCS_SWTS;
+    if (_period == 0) {
+      // clear eosf and trigger scan
+      TSI0_GENCS |= TSI_GENCS_EOSF | TSI_GENCS_SWTS;
+    } else {
+      // clear eosf and wait for timerISR
+      TSI0_GENCS |= TSI_GENCS_EOSF;
+      _busy = 0;
+    }
 #elif  defined(HAS_KINETIS_TSI_LITE)
     // fetch counts and combine with running average
-    _value[_cactive] = (TSI0_DATA & 0xFFFF);
+    uint16_t value = (TSI0_DATA & 0xFFFF);
+    if (_idleEvery != 0) heat(_cactive, value);
+    _value[_cactive] = value;
     // advance to next electrode
-    if (++_pactive >= _nactive) {
+    bool done = false;
+    if (++_nslot >= _nactive) {
       // count end of scan
       _clock += 1;
+      _scanMicros = micros();
       if (_callback != NULL) _callback(_value);
       // restart scan
-      _pactive = 0;
+      _nslot = 0;
+      done = _period != 0;
     }
     // get next electrode number
-    _cactive = _active[_pactive];
+    _cactive = nextChannel();
     // reset the end-of-scan flag
     TSI0_GENCS |= TSI_GENCS_EOSF;
-    // reprogram for next scan, and trigger
-    TSI0_DATA = TSI_DATA_TSICH(_cactive) | TSI_DATA_SWTS;
+    if (done) {
+      // program for next scan, wait for timerISR to trigger
+      TSI0_DATA = TSI_DATA_TSICH(_cactive);
+      _busy = 0;
+    } else {
+      // reprogram for next scan, and trigger
+      TSI0_DATA = TSI_DATA_TSICH(_cactive) | TSI_DATA_SWTS;
+    }
 #endif
   }
+
+#if defined(HAS_KINETIS_TSI_LITE)
+ private:
+  /* update the hot state of a channel just measured */
+  static void heat(uint8_t channel, uint16_t value) {
+    uint16_t old = _value[channel];
+    uint16_t delta = value > old ? value-old : old-value;
+    if (delta > _hotDelta) {
+      if (_hot[channel] == 0) _nhot += 1;
+      _hot[channel] = _hotHold;
+    } else if (_hot[channel] != 0 && --_hot[channel] == 0) {
+      _nhot -= 1;
+    }
+  }
+  /* choose the next electrode to measure */
+  static uint8_t nextChannel() {
+    if (_idleEvery != 0 && _nhot != 0 && ++_slot % _idleEvery != 0) {
+      // next hot channel after the last one
+      for (int i = 0; i < _nactive; i += 1) {
+	if (++_phot >= _nactive) _phot = 0;
+	if (_hot[_active[_phot]]) return _active[_phot];
+      }
+    }
+    // round robin
+    if (++_pactive >= _nactive) _pactive = 0;
+    return _active[_pactive];
+  }
+#endif
 };
 #endif // TeensyTouch_h
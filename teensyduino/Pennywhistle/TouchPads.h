@@ -21,6 +21,8 @@
 
 #include "Teensy3Touch.h"
 #include "debouncer.h"
+#include "padfilter.h"
+#include "PadAverage.h"
 
 // this might be improved if it made an instance
 // with npads and pins as constructor parameters
@@ -36,11 +38,12 @@ namespace TouchPads {
   static uint8_t _pads[NPADS];
   static uint8_t _channels[NPADS];
 
-  static uint16_t _touch[NPADS];
-  static uint16_t _avgTouch[NPADS];
+  // word aligned and padded for PadAverage
+  static uint16_t _touch[2*PAD_WORDS(NPADS)] __attribute__((aligned(4)));
+  static uint16_t _avgTouch[2*PAD_WORDS(NPADS)] __attribute__((aligned(4)));
   static uint8_t _electrodes[NPADS];
-  static uint16_t _minTouch[NPADS];
-  static uint16_t _maxTouch[NPADS];
+  static uint16_t _minTouch[2*PAD_WORDS(NPADS)] __attribute__((aligned(4)));
+  static uint16_t _maxTouch[2*PAD_WORDS(NPADS)] __attribute__((aligned(4)));
   static uint8_t _normTouch[NPADS];
   static uint8_t _threshold[NPADS];
   static uint8_t _expo;
@@ -48,8 +51,10 @@ namespace TouchPads {
 
   static uint8_t _callbackFlag;
   static uint32_t _callbackCount;
+  static uint32_t _callbackMicros;
 
   static debouncer _debouncer[NPADS];
+  static padfilter _filter[NPADS];
   
   static void reset() {
     for (int i = 0; i < _npads; i += 1) {
@@ -59,32 +64,10 @@ namespace TouchPads {
     }
   }
 
-  // compute exponential average
-  // return (avg + val) / 2
-  // return (avg + 2*avg + val) / 4;				// 3/4 + 1/4
-  // return (avg + 2*avg + 4*avg + val) / 8;			// 7/8 + 1/8
-  // return (avg + 2*avg + 4*avg + 8*avg + val) / 16;		// 15/16 + 1/16
-  // return (avg + 2*avg + 4*avg + 8*avg + 16*avg + val) / 32;	// 31/32 + 1/32
-  static uint16_t average(uint16_t avg, uint16_t val) {
-    uint16_t acc = avg;
-    switch (_expo) {
-    case 0: return val;
-    case 8: acc <<= 1; acc += avg; // fall through
-    case 7: acc <<= 1; acc += avg; // fall through
-    case 6: acc <<= 1; acc += avg; // fall through
-    case 5: acc <<= 1; acc += avg; // fall through
-    case 4: acc <<= 1; acc += avg; // fall through
-    case 3: acc <<= 1; acc += avg; // fall through
-    case 2: acc <<= 1; acc += avg; // fall through
-    case 1: break;
-    }
-    acc += val;
-    return acc >> _expo;
-  }
-
   static void _callback(uint16_t *value) {
     _callbackFlag += 1;
     _callbackCount += 1;
+    _callbackMicros = Teensy3Touch::scanMicros();
     if (_callbackCount == 256) reset();
     for (int i = 0; i < _npads; i += 1) {
       uint16_t val = value[_channels[i]];
@@ -92,12 +75,11 @@ namespace TouchPads {
 	_electrodes[i] |= 1; 
 	val = _minTouch[i];
       }
-      _touch[i] = val;		// maybe average here, too, a little?
+      _touch[i] = _filter[i].filter(val);
       if (_avgTouch[i] == 0) _avgTouch[i] = val;
-      _avgTouch[i] = average(_avgTouch[i], val);
-      _maxTouch[i] = max(_maxTouch[i], _avgTouch[i]);
-      _minTouch[i] = min(_minTouch[i], _avgTouch[i]);
     }
+    // exponential average, then min and max of the average
+    PadAverage::update(_avgTouch, _minTouch, _maxTouch, _touch, _npads, _expo);
   }
 
   // set the off/on threshold for normalized touch values
@@ -113,8 +95,47 @@ namespace TouchPads {
   static void set_steps(uint8_t steps, int i) {
     _debouncer[i].setSteps(steps);
   }
+  // configure the per pad filters, see padfilter.h
+  static void set_filter_median(uint8_t on) {
+    for (int i = 0; i < _npads; i += 1) _filter[i].setMedian(on);
+  }
+  static void set_filter_median(uint8_t on, int i) {
+    _filter[i].setMedian(on);
+  }
+  static void set_filter_type(uint8_t type) {
+    for (int i = 0; i < _npads; i += 1) _filter[i].setType(type);
+  }
+  static void set_filter_type(uint8_t type, int i) {
+    _filter[i].setType(type);
+  }
+  static void set_filter_cutoff(uint8_t cutoff) {
+    for (int i = 0; i < _npads; i += 1) _filter[i].setCutoff(cutoff);
+  }
+  static void set_filter_cutoff(uint8_t cutoff, int i) {
+    _filter[i].setCutoff(cutoff);
+  }
+  static void set_filter_q(uint8_t q) {
+    for (int i = 0; i < _npads; i += 1) _filter[i].setQ(q);
+  }
+  static void set_filter_q(uint8_t q, int i) {
+    _filter[i].setQ(q);
+  }
+  // the same settings in real time units, these need a fixed scan period
+  static uint32_t scan_period() { return Teensy3Touch::period(); }
+  static uint8_t steps_from_ms(uint8_t ms) {
+    uint32_t steps = scan_period() ? (1000 * (uint32_t)ms + scan_period()/2) / scan_period() : DEBOUNCER_STEPS;
+    return constrain(steps, 1u, 31u);	/* the debouncer shifts 1L by steps-1 */
+  }
+  static void set_debounce_ms(uint8_t ms) { set_steps(steps_from_ms(ms)); }
+  static void set_debounce_ms(uint8_t ms, int i) { set_steps(steps_from_ms(ms), i); }
+  static uint8_t cutoff_from_hz(float hz) {
+    uint32_t cutoff = scan_period() ? hz * 256e-6f * scan_period() + 0.5f : PAD_FILTER_CUTOFF;
+    return constrain(cutoff, 1u, 127u);
+  }
+  static void set_filter_cutoff_hz(float hz) { set_filter_cutoff(cutoff_from_hz(hz)); }
+  static void set_filter_cutoff_hz(float hz, int i) { set_filter_cutoff(cutoff_from_hz(hz), i); }
   static void set_average(uint8_t expo) {
-    _expo = expo;
+    _expo = min(expo, PadAverage::max_expo);
   }
   // see if a new touch configuration is available
   static bool available() {
@@ -128,6 +149,10 @@ namespace TouchPads {
       uint16_t excess = value-_minTouch[i];
       _normTouch[i] = range < 5 ? 0 : excess >= range ? 255 : scale * excess;
       if (_debouncer[i].debounce(_normTouch[i] > _threshold[i] ? 1 : 0)) new_touch |= 1<<i;
+#if defined(HAS_KINETIS_TSI_LITE)
+      // near the threshold, measure this pad more often
+      if (abs(_normTouch[i] - _threshold[i]) < 0x20) Teensy3Touch::setHot(_channels[i]);
+#endif
     }
     if (new_touch != _last_touch) {
       _last_touch = new_touch;
@@ -137,6 +162,8 @@ namespace TouchPads {
   }
 
   static uint32_t clock() { return _callbackCount; }
+  // micros() when the last scan completed, per scan even in batches
+  static uint32_t stamp() { return _callbackMicros; }
   static uint16_t last_touch() { return _last_touch; }
   static uint16_t touch(int i) { return _touch[i]; }
   static uint16_t avgTouch(int i) { return _avgTouch[i]; }
@@ -157,8 +184,23 @@ namespace TouchPads {
       set_steps(DEBOUNCER_STEPS, i);
       set_threshold(TOUCH_THRESHOLD, i);
       set_average(SOFTWARE_AVERAGING);
+      set_filter_median(PAD_FILTER_MEDIAN, i);
+      set_filter_type(PAD_FILTER_TYPE, i);
+      set_filter_cutoff(PAD_FILTER_CUTOFF, i);
+      set_filter_q(PAD_FILTER_Q, i);
     }
     reset();
+#if defined(HAS_KINETIS_TSI_LITE)
+    Teensy3Touch::setAdaptive(TOUCH_ADAPTIVE);
+#endif
+#if defined(HAS_KINETIS_TSI)
+    if (TOUCH_BATCH_PERIOD != 0 &&
+	Teensy3Touch::startBatch(maskpins,TOUCH_BATCH_PERIOD,3,2,HARDWARE_AVERAGING,2,_callback))
+      return;
+#endif
+    if (TOUCH_SCAN_PERIOD != 0 &&
+	Teensy3Touch::startPeriodic(maskpins,TOUCH_SCAN_PERIOD,3,2,HARDWARE_AVERAGING,2,_callback))
+      return;
     Teensy3Touch::start(maskpins,3,2,HARDWARE_AVERAGING,2,_callback);// 1 scan
   }
 
@@ -0,0 +1,108 @@
+/* -*- mode: c++; tab-width: 8 -*- */
+/*
+  Copyright (C) 2018 by Roger E Critchlow Jr, Charlestown, MA, USA.
+
+  This program is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation; either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program; if not, write to the Free Software
+  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307 USA
+*/
+/*
+** A tuning table, so the fingered notes, the keys, can sound any
+** pitch, just intonation or scales which aren't 12 tone at all.
+**
+** Each key is tuned to a pitch in semitones, which is kept as the
+** nearest 12 tone note and the cents from it, and the frequency.
+** MIDI plays the key as the note, with the cents added to its pitch
+** bend, the onboard voice plays the frequency, or the note bent by
+** the cents and the breath bend, see Midi::hertz().  So a tuned note
+** costs a table lookup.  Pitches are from A 440, and follow a change
+** to Midi::tuning() after refresh().
+**
+** retune() takes key pitches as the MIDI Tuning Standard writes them,
+** four 7 bit bytes a key,
+**   key, semitone, fraction msb, fraction lsb
+** the fraction in 1/16384 semitone, and 7F 7F 7F leaves the key as it
+** is.  host/scala.cpp converts Scala .scl and .kbm files into these,
+** as SysEx messages of 32 keys each, under the USB sysex size.  An
+** empty retune() returns to equal temperament.  The receiver's bend
+** range should cover the cents, a semitone each way at least.
+*/
+#ifndef Tuning_h
+#define Tuning_h
+
+#include "Midi.h"
+
+namespace Tuning {
+  static uint8_t _note[128];		/* the nearest 12 tone note for each key */
+  static float _cents[128];		/* the cents from it */
+  static float _hertz[128];		/* the frequency */
+  static uint8_t _retuned;		/* keys not in equal temperament */
+
+  /* recompute the frequencies, after Midi::tuning() changes */
+  void refresh() {
+    _retuned = 0;
+    for (int key = 0; key < 128; key += 1) {
+      _hertz[key] = Midi::hertz(_note[key], _cents[key]);
+      if (_note[key] != key || _cents[key] != 0) _retuned += 1;
+    }
+  }
+  /* equal temperament */
+  void equal() {
+    for (int key = 0; key < 128; key += 1) {
+      _note[key] = key;
+      _cents[key] = 0;
+    }
+    refresh();
+  }
+  /* n bytes of key pitches, 4 a key, false if they aren't */
+  bool retune(const uint8_t *data, int n) {
+    if (n == 0) {
+      equal();
+      return true;
+    }
+    if (n % 4 != 0) return false;
+    for (int j = 0; j < n; j += 1) if (data[j] > 127) return false;
+    for (int j = 0; j < n; j += 4) {
+      if (data[j+1] == 0x7F && data[j+2] == 0x7F && data[j+3] == 0x7F) continue;
+      float pitch = data[j+1] + ((data[j+2] << 7) | data[j+3]) / 16384.0f;
+      int note = pitch < 127 ? (int)(pitch + 0.5f) : 127;
+      _note[data[j]] = note;
+      _cents[data[j]] = (pitch - note) * 100.0f;
+    }
+    refresh();
+    return true;
+  }
+
+  /* the 12 tone note a key plays */
+  inline uint8_t note(uint8_t key) { return _note[key & 127]; }
+  /* the cents from that note */
+  inline float cents(uint8_t key) { return _cents[key & 127]; }
+  /* the frequency of a key, bent by cents */
+  inline float hertz(uint8_t key, float bend = 0) {
+    key &= 127;
+    return bend == 0 ? _hertz[key] : Midi::hertz(_note[key], _cents[key] + bend);
+  }
+
+  int begin() {
+    equal();
+    return 1;
+  }
+  void report() {
+    Serial.printf("tuning A %5.1fHz, %d keys retuned:", Midi::tuning(), _retuned);
+    for (int key = Midi::middle_C; key <= Midi::middle_C + 12; key += 1)
+      Serial.printf(" %d:%d%+.1f", key, _note[key], _cents[key]);
+    Serial.printf("\n");
+  }
+};
+
+#endif // Tuning_h
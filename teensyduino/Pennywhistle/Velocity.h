@@ -0,0 +1,135 @@
+/* -*- mode: c++; tab-width: 8 -*- */
+/*
+  Copyright (C) 2018 by Roger E Critchlow Jr, Charlestown, MA, USA.
+
+  This program is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation; either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program; if not, write to the Free Software
+  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307 USA
+*/
+/*
+** NoteOn velocity from how fast the breath rises at the onset.
+**
+** A note started from silence waits for its NoteOn while the breath
+** is measured over window() milliseconds of breath samples, from the
+** sample before the onset.  The velocity is the rise over that time,
+** full() breath per second for 127, or the level reached, through
+** the breath curve, if that's more, so a note fingered into a held
+** breath isn't soft.  The wait is strictly capped: once cap()
+** milliseconds have passed since the onset poll() finishes with what
+** has been measured so far, so a slow breath update never costs more
+** than the cap.  The mic and the barometer stamp their samples from
+** different clocks, so stamps are compared as signed differences and
+** a sample stamped no later than the last is ignored.
+**
+** Notes changed while the breath sounds take the velocity of the
+** last onset, without waiting.  report() gives the onsets, how many
+** were cut short by the cap, the velocities, and the distribution of
+** the added latency, in milliseconds.
+*/
+#ifndef Velocity_h
+#define Velocity_h
+
+#include "BreathCurve.h"
+
+namespace Velocity {
+  static const int BINS = 16;		/* 1ms latency bins, the last is 15ms and more */
+
+  static uint32_t _window = 6000, _cap = 10000;
+  static float _full = 25.0f;
+  static float _last, _prev, _base;
+  static uint32_t _lastStamp, _prevStamp, _baseStamp, _onsetStamp, _onsetMicros;
+  static uint8_t _pending, _velocity = 100;
+
+  static uint32_t _onsets, _capped, _velocitySum;
+  static uint64_t _latencySum;
+  static uint32_t _latencyMax;
+  static uint16_t _bins[BINS];
+
+  /* the breath measured for velocity, in milliseconds */
+  void window(uint32_t ms) { _window = constrain(ms, 1u, 50u) * 1000; }
+  /* the most latency velocity may add, in milliseconds */
+  void cap(uint32_t ms) { _cap = constrain(ms, 1u, 50u) * 1000; }
+  /* the rise, in full breath per second, for velocity 127 */
+  void full(float f) { _full = constrain(f, 0.5f, 200.0f); }
+  /* true while a NoteOn waits for its velocity */
+  bool pending() { return _pending; }
+  /* the velocity of the last onset */
+  uint8_t velocity() { return _velocity; }
+
+  /* finish measuring, at now micros, returns the velocity */
+  uint8_t finish(uint32_t now) {
+    uint32_t dt = _lastStamp - _baseStamp;
+    float rise = dt > 0 ? (_last - _base) * 1e6f / dt : 0;
+    int32_t v = 127 * rise / _full;
+    int32_t level = BreathCurve::map((int32_t)(_last * 32767.0f)) >> 8;
+    if (level > v) v = level;
+    _velocity = constrain(v, 1, 127);
+    _pending = 0;
+    uint32_t latency = now - _onsetMicros;
+    _onsets += 1;
+    _velocitySum += _velocity;
+    _latencySum += latency;
+    if (latency > _latencyMax) _latencyMax = latency;
+    _bins[min(latency / 1000, (uint32_t)BINS-1)] += 1;
+    return _velocity;
+  }
+
+  /* a note starts from silence at the breath sample stamp, now micros */
+  void start(uint32_t stamp, uint32_t now) {
+    _pending = 1;
+    _onsetStamp = stamp;
+    _onsetMicros = now;
+    _base = _prev;
+    _baseStamp = _prevStamp;
+  }
+  /* the note stopped before its NoteOn */
+  void cancel() { _pending = 0; }
+
+  /* each breath level, 0 to 1, at stamp micros, returns a velocity once the window is measured, else 0 */
+  uint8_t sample(float level, uint32_t stamp, uint32_t now) {
+    if ((int32_t)(stamp - _lastStamp) <= 0) return 0;
+    _prev = _last; _prevStamp = _lastStamp;
+    _last = level; _lastStamp = stamp;
+    if (_pending && (int32_t)(stamp - _onsetStamp) >= (int32_t)_window) return finish(now);
+    return 0;
+  }
+  /* at now micros, returns a velocity if the cap is reached, else 0 */
+  uint8_t poll(uint32_t now) {
+    if (_pending && now - _onsetMicros >= _cap) {
+      _capped += 1;
+      return finish(now);
+    }
+    return 0;
+  }
+
+  int begin() {
+    window(VELOCITY_WINDOW_MS);
+    cap(VELOCITY_CAP_MS);
+    full(VELOCITY_FULL);
+    return 1;
+  }
+  void report() {
+    Serial.printf("velocity window %lums cap %lums full %4.1f/s, onsets %lu, capped %lu, velocity avg %lu\n",
+		  (unsigned long)_window / 1000, (unsigned long)_cap / 1000, _full, (unsigned long)_onsets,
+		  (unsigned long)_capped, _onsets ? (unsigned long)(_velocitySum / _onsets) : 0UL);
+    Serial.printf("added latency avg %luus max %luus, ms:", _onsets ? (unsigned long)(_latencySum / _onsets) : 0UL,
+		  (unsigned long)_latencyMax);
+    for (int i = 0; i < BINS; i += 1) if (_bins[i]) Serial.printf(" %d%s:%d", i, i == BINS-1 ? "+" : "", _bins[i]);
+    Serial.printf("\n");
+    _onsets = _capped = _velocitySum = 0;
+    _latencySum = 0; _latencyMax = 0;
+    memset(_bins, 0, sizeof(_bins));
+  }
+};
+
+#endif // Velocity_h
@@ -0,0 +1,130 @@
+/* -*- mode: c++; tab-width: 8 -*- */
+/*
+  Copyright (C) 2018 by Roger E Critchlow Jr, Charlestown, MA, USA.
+
+  This program is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation; either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program; if not, write to the Free Software
+  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307 USA
+*/
+/*
+** Per pad filter for raw touch counts, one sample per scan.
+**
+** An optional median of three removes single scan spikes,
+** then an optional one pole or biquad lowpass smooths what's left.
+**
+** The cutoff is specified as a 7 bit code, cutoff/256 of the scan rate,
+** and the biquad Q as a 7 bit code, Q*16, so both can be set from
+** a MIDI control change.  Coefficients are computed in float when
+** they change and run in fixed point: Q28 coefficients, state with
+** 8 fractional bits, 64 bit products.  They change from loop() while
+** the scan interrupt filters, so they're computed aside and swapped
+** in with interrupts off, and a scan never runs a half made filter.
+**
+** The median of three delays a change of touch by one scan.
+*/
+#ifndef padfilter_h
+#define padfilter_h 1
+
+#include <stdint.h>
+#include <math.h>
+
+class padfilter {
+ public:
+  static const uint8_t NONE = 0;
+  static const uint8_t ONEPOLE = 1;
+  static const uint8_t BIQUAD = 2;
+
+  padfilter() {
+    _median = 0;
+    _type = NONE;
+    _cutoff = 32;
+    _q = 11;
+    design();
+    reset();
+  }
+
+  uint16_t filter(uint16_t x) {
+    if ( ! _primed) prime(x);
+    if (_median) {
+      uint16_t a = _m[0], b = _m[1];
+      _m[0] = b; _m[1] = x;
+      x = max16(min16(a, b), min16(max16(a, b), x));
+    }
+    int32_t xq = (int32_t)x << 8;
+    switch (_type) {
+    case ONEPOLE:
+      _y1 += ((int64_t)(xq - _y1) * _k) >> 16;
+      break;
+    case BIQUAD: {
+      int64_t acc = (int64_t)_b0 * xq + (int64_t)_b1 * _x1 + (int64_t)_b2 * _x2
+	- (int64_t)_a1 * _y1 - (int64_t)_a2 * _y2;
+      _x2 = _x1; _x1 = xq;
+      _y2 = _y1; _y1 = acc >> 28;
+      break;
+    }
+    default:
+      return x;
+    }
+    int32_t y = (_y1 + 128) >> 8;
+    return y < 0 ? 0 : y > 65535 ? 65535 : y;
+  }
+
+  void reset() { _primed = 0; }
+
+  void setMedian(uint8_t on) { _median = on != 0; }
+  void setType(uint8_t type) { _type = type <= BIQUAD ? type : NONE; reset(); }
+  void setCutoff(uint8_t cutoff) { _cutoff = constrain7(cutoff); design(); }
+  void setQ(uint8_t q) { _q = constrain7(q); design(); }
+
+  uint8_t getMedian() { return _median; }
+  uint8_t getType() { return _type; }
+  uint8_t getCutoff() { return _cutoff; }
+  uint8_t getQ() { return _q; }
+
+ private:
+  static uint16_t min16(uint16_t a, uint16_t b) { return a < b ? a : b; }
+  static uint16_t max16(uint16_t a, uint16_t b) { return a > b ? a : b; }
+  static uint8_t constrain7(uint8_t v) { return v < 1 ? 1 : v > 127 ? 127 : v; }
+
+  // start the history at the first sample so there's no ramp up from zero
+  void prime(uint16_t x) {
+    _m[0] = _m[1] = x;
+    _x1 = _x2 = _y1 = _y2 = (int32_t)x << 8;
+    _primed = 1;
+  }
+
+  void design() {
+    float w = 2.0f * (float)M_PI * _cutoff / 256.0f;
+    // RBJ cookbook lowpass, normalized by a0
+    float q = _q / 16.0f;
+    float cw = cosf(w), alpha = sinf(w) / (2.0f * q), a0 = 1.0f + alpha;
+    float scale = 268435456.0f / a0;
+    int32_t k = (int32_t)(65536.0f * (1.0f - expf(-w)));
+    int32_t b0 = (int32_t)(scale * (1.0f - cw) / 2.0f);
+    int32_t b1 = (int32_t)(scale * (1.0f - cw));
+    int32_t a1 = (int32_t)(scale * -2.0f * cw);
+    int32_t a2 = (int32_t)(scale * (1.0f - alpha));
+    __disable_irq();
+    _k = k;
+    _b0 = b0; _b1 = b1; _b2 = b0;
+    _a1 = a1; _a2 = a2;
+    __enable_irq();
+  }
+
+  uint8_t _median, _type, _cutoff, _q, _primed;
+  uint16_t _m[2];
+  int32_t _k;
+  int32_t _b0, _b1, _b2, _a1, _a2;
+  int32_t _x1, _x2, _y1, _y2;
+};
+#endif // padfilter_h